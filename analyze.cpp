@@ -0,0 +1,163 @@
+// Board analysis without playing games: solves where players land and
+// turns that into expected rent and payback times for every purchase.
+//
+//   analyze [-m map.dat] [-p players] [--turns N] [--csv]
+//
+// By default the landing odds are the long-run (stationary) ones of the
+// movement chain; --turns N uses the average over the first N turns of a
+// game instead, starting from GO. "rent/round" is what the owner collects
+// per round from the other players, "payback" is the cost divided by it.
+//
+// Rows per unit: levels 1..5 for U (cost includes the upgrades), owned
+// collectable counts for C, the mean fine (3.5 x finePerPoint) for R.
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fast_game.h"
+#include "map.h"
+#include "map_image.h"
+#include "markov.h"
+
+namespace {
+
+struct Row {
+    int unit;
+    char kind;
+    int level;      // U level, or number of collectables owned
+    long cost;
+    double fine;
+};
+
+void emit(const Row& row, const std::string& name, double landing, int numPlayers, bool csv) {
+    double rent = landing * row.fine * (numPlayers - 1);
+    double payback = rent > 0 ? row.cost / rent : 0;
+    if (csv) {
+        std::cout << row.unit << "," << name << "," << row.kind << "," << row.level << ","
+                  << row.cost << "," << row.fine << "," << landing << "," << rent << ",";
+        if (rent > 0) std::cout << payback;
+        std::cout << "\n";
+        return;
+    }
+    std::cout << std::setw(6) << row.unit << "  " << std::setw(12) << std::left << name.substr(0, 12)
+              << std::right << "  " << row.kind << std::setw(6) << row.level
+              << std::setw(9) << row.cost << std::setw(9) << std::setprecision(0) << row.fine
+              << std::setw(9) << std::setprecision(3) << landing * 100
+              << std::setw(12) << std::setprecision(1) << rent;
+    if (rent > 0) std::cout << std::setw(11) << payback;
+    else std::cout << std::setw(11) << "-";
+    std::cout << "\n";
+}
+
+// Collectable counts worth a row: 1..4 and the whole set.
+std::vector<int> collectableCounts(int total) {
+    std::vector<int> counts;
+    for (int k = 1; k <= total && k <= 4; ++k) counts.push_back(k);
+    if (total > 4) counts.push_back(total);
+    return counts;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string mapPath = "map.dat";
+    int numPlayers = 4;
+    int turns = 0;
+    bool csv = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-m" && hasValue) mapPath = argv[++i];
+        else if (arg == "-p" && hasValue) numPlayers = std::atoi(argv[++i]);
+        else if (arg == "--turns" && hasValue) turns = std::atoi(argv[++i]);
+        else if (arg == "--csv") csv = true;
+        else {
+            std::cerr << "usage: analyze [-m map.dat] [-p players] [--turns N] [--csv]\n";
+            return 1;
+        }
+    }
+    if (numPlayers < 2) numPlayers = 2;
+
+    // Same loading rule as tournament: a compiled image, else map.dat text.
+    MapImage image;
+    std::string imageError;
+    std::vector<UnitSpec> specs;
+    if (image.open(mapPath, imageError)) {
+        specs = image.toSpecs();
+    } else {
+        std::vector<std::string> errors;
+        parseMapFile(mapPath, specs, errors);
+        for (const auto& error : errors) std::cerr << error << "\n";
+    }
+    if (specs.empty()) {
+        std::cerr << mapPath << ": no units\n";
+        return 1;
+    }
+    BoardLayout layout(specs);
+
+    auto start = std::chrono::steady_clock::now();
+    LandingChain chain(layout);
+    bool converged = true;
+    if (turns > 0) chain.solveOpening(turns);
+    else converged = chain.solveStationary();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> landing = chain.getLanding();
+    if (turns > 0) {
+        for (double& l : landing) l /= turns;
+    }
+
+    int totalCollectables = 0;
+    for (const auto& spec : specs) {
+        if (spec.kind == UnitKind::Collectable) ++totalCollectables;
+    }
+
+    std::cerr << std::fixed << std::setprecision(3);
+    std::cerr << mapPath << ": " << specs.size() << " units, " << numPlayers << " players\n";
+    if (turns > 0) {
+        std::cerr << "opening: first " << turns << " turns from GO, solved in " << ms << " ms\n";
+    } else {
+        std::cerr << "stationary: " << chain.getIterations() << " iterations, residual "
+                  << std::scientific << chain.getResidual() << std::fixed << ", solved in " << ms << " ms\n";
+        std::cerr << "frozen in jail " << chain.getFrozenShare() * 100 << "% of turns\n";
+        if (!converged) std::cerr << "warning: did not converge\n";
+    }
+
+    if (csv) {
+        std::cout << "unit,name,kind,level,cost,fine,landing,rent_per_round,payback_rounds\n";
+        std::cout << std::setprecision(9);
+    } else {
+        std::cout << std::fixed;
+        std::cout << "  unit  name          kind level     cost     fine    land%  rent/round    payback\n";
+    }
+
+    for (int u = 0; u < int(specs.size()); ++u) {
+        const UnitSpec& spec = specs[u];
+        switch (spec.kind) {
+        case UnitKind::Upgradable:
+            for (int level = 1; level <= 5; ++level) {
+                long cost = spec.price + long(level - 1) * spec.upgradePrice;
+                emit(Row{u, 'U', level, cost, double(spec.fines[level - 1])}, spec.name, landing[u], numPlayers, csv);
+            }
+            break;
+        case UnitKind::Collectable:
+            // The fine scales with how many collectables the owner holds;
+            // the cost is this unit's price alone.
+            for (int count : collectableCounts(totalCollectables)) {
+                emit(Row{u, 'C', count, spec.price, double(count) * spec.param}, spec.name, landing[u], numPlayers, csv);
+            }
+            break;
+        case UnitKind::RandomCost:
+            emit(Row{u, 'R', 1, spec.price, 3.5 * spec.param}, spec.name, landing[u], numPlayers, csv);
+            break;
+        case UnitKind::Jail:
+            emit(Row{u, 'J', 0, 0, 0.0}, spec.name, landing[u], numPlayers, csv);
+            break;
+        }
+    }
+    return 0;
+}
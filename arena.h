@@ -0,0 +1,62 @@
+#ifndef ARENA__
+#define ARENA__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// ================== Arena ==================
+// A fixed block of memory handed out by bumping a pointer. The block is
+// allocated once; allocate() never touches the heap and reset() releases
+// everything in O(1). Only for trivially destructible types: nothing
+// allocated here is ever destroyed individually.
+class Arena {
+public:
+    Arena() = default;
+    explicit Arena(size_t capacity) { reserve(capacity); }
+    ~Arena() { std::free(base_); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Replaces the block with one of at least `capacity` bytes (only if the
+    // current one is smaller). Invalidates everything handed out so far.
+    void reserve(size_t capacity) {
+        used_ = 0;
+        if (capacity <= capacity_) return;
+        std::free(base_);
+        base_ = static_cast<char*>(std::malloc(capacity));
+        if (!base_) throw std::bad_alloc();
+        capacity_ = capacity;
+    }
+
+    // Returns uninitialized storage for count objects of T, or nullptr if
+    // the block is exhausted.
+    template <class T>
+    T* allocate(size_t count) {
+        size_t offset = (used_ + alignof(T) - 1) & ~(alignof(T) - 1);
+        size_t bytes = sizeof(T) * count;
+        if (offset + bytes > capacity_) return nullptr;
+        used_ = offset + bytes;
+        return reinterpret_cast<T*>(base_ + offset);
+    }
+
+    void reset() { used_ = 0; }
+
+    size_t getUsed() const { return used_; }
+    size_t getCapacity() const { return capacity_; }
+
+    // Upper bound of the bytes allocate<T>(count) can consume, for sizing
+    // an arena before the allocations are made.
+    template <class T>
+    static constexpr size_t footprint(size_t count) {
+        return sizeof(T) * count + alignof(T) - 1;
+    }
+
+private:
+    char* base_ = nullptr;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+};
+
+#endif
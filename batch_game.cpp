@@ -0,0 +1,368 @@
+#include "batch_game.h"
+#include <algorithm>
+#include <climits>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define BATCH_HAVE_AVX2_PATH 1
+#endif
+
+
+namespace {
+const int32_t kNoOwner = -1;
+const int32_t kUpgradable = int32_t(UnitKind::Upgradable);
+const int32_t kCollectable = int32_t(UnitKind::Collectable);
+const int32_t kRandomCost = int32_t(UnitKind::RandomCost);
+const int32_t kJail = int32_t(UnitKind::Jail);
+const int32_t kNormal = int32_t(PlayerStatus::Normal);
+const int32_t kInJail = int32_t(PlayerStatus::InJail);
+const int32_t kBankrupt = int32_t(PlayerStatus::Bankrupt);
+}
+
+// ================== Batch Game ==================
+BatchGame::BatchGame(const BoardLayout& board, int numPlayers, int reserve)
+    : unitCount_(board.unitCount), numPlayers_(numPlayers < 1 ? 1 : numPlayers) {
+    const int n = unitCount_;
+    kind_.resize(n);
+    price_.assign(board.price, board.price + n);
+    upgradePrice_.assign(board.upgradePrice, board.upgradePrice + n);
+    param_.assign(board.param, board.param + n);
+    fines_.assign(board.fines, board.fines + n * 5);
+    step_.assign(n * 8, 0);
+    for (int u = 0; u < n; ++u) {
+        kind_[u] = int32_t(board.kind[u]);
+        for (int die = 0; die < 8; ++die) {
+            step_[u * 8 + die] = (u + die) % n;
+        }
+    }
+    reserve_.assign(numPlayers_, reserve);
+
+    owner_.resize(n * kLanes);
+    level_.resize(n * kLanes);
+    location_.resize(numPlayers_ * kLanes);
+    money_.resize(numPlayers_ * kLanes);
+    status_.resize(numPlayers_ * kLanes);
+    collectables_.resize(numPlayers_ * kLanes);
+    reset(0, 0, 0);
+}
+
+void BatchGame::setReserve(int seat, int reserve) {
+    if (seat >= 0 && seat < numPlayers_) reserve_[seat] = reserve;
+}
+
+bool BatchGame::usesAvx2() {
+#ifdef BATCH_HAVE_AVX2_PATH
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return false;
+#endif
+}
+
+void BatchGame::reset(uint64_t seed, uint64_t first, int count) {
+    count_ = std::clamp(count, 0, kLanes);
+    std::fill(owner_.begin(), owner_.end(), kNoOwner);
+    std::fill(level_.begin(), level_.end(), 1);
+    std::fill(location_.begin(), location_.end(), 0);
+    std::fill(money_.begin(), money_.end(), 30000);
+    std::fill(status_.begin(), status_.end(), kNormal);
+    std::fill(collectables_.begin(), collectables_.end(), 0);
+    for (int lane = 0; lane < kLanes; ++lane) {
+        rng_[lane / kWidth].seed(lane % kWidth, seed, first + lane);
+        turns_[lane] = 0;
+        active_[lane] = numPlayers_;
+        // Lanes without a game start out finished.
+        over_[lane] = lane < count_ ? 0 : 1;
+    }
+}
+
+void BatchGame::play(uint64_t seed, uint64_t first, int count, long maxTurns) {
+    reset(seed, first, count);
+    const int32_t cap = int32_t(std::min<long>(maxTurns, INT_MAX));
+    const bool avx2 = usesAvx2();
+    // A finished lane is masked off, so looking only once per round costs
+    // nothing but a few empty steps at the end.
+    for (bool running = true; running;) {
+        for (int p = 0; p < numPlayers_; ++p) {
+            if (avx2) stepAvx2(p, cap);
+            else stepScalar(p, cap);
+        }
+        running = false;
+        for (int lane = 0; lane < kLanes; ++lane) {
+            running |= !over_[lane] && turns_[lane] < cap;
+        }
+    }
+}
+
+int BatchGame::getWinner(int lane) const {
+    int leader = -1;
+    for (int i = 0; i < numPlayers_; ++i) {
+        if (status_[i * kLanes + lane] == kBankrupt) continue;
+        if (leader < 0 || money_[i * kLanes + lane] > money_[leader * kLanes + lane]) {
+            leader = i;
+        }
+    }
+    return leader;
+}
+
+void BatchGame::bankrupt(int lane, int p) {
+    status_[p * kLanes + lane] = kBankrupt;
+    for (int u = 0; u < unitCount_; ++u) {
+        if (owner_[u * kLanes + lane] == p) {
+            owner_[u * kLanes + lane] = kNoOwner;
+            level_[u * kLanes + lane] = 1;
+        }
+    }
+    collectables_[p * kLanes + lane] = 0;
+    if (--active_[lane] <= 1) over_[lane] = 1;
+}
+
+// One turn of seat p in every running lane, lane by lane; the reference
+// for stepAvx2() and the same rules as FastGame::playTurn().
+void BatchGame::stepScalar(int p, int32_t maxTurns) {
+    const int32_t reserve = reserve_[p];
+    for (int lane = 0; lane < kLanes; ++lane) {
+        if (over_[lane] || turns_[lane] >= maxTurns) continue;
+        const int pl = p * kLanes + lane;
+        if (status_[pl] == kBankrupt) continue;
+        ++turns_[lane];
+        if (status_[pl] == kInJail) {
+            status_[pl] = kNormal;
+            continue;
+        }
+
+        int32_t oldLocation = location_[pl];
+        int32_t u = step_[oldLocation * 8 + rng_[lane / kWidth].rollLane(lane % kWidth)];
+        int32_t money = money_[pl];
+        if (u < oldLocation) money += 2000;
+        location_[pl] = u;
+
+        const int ul = u * kLanes + lane;
+        const int32_t kind = kind_[u];
+        const int32_t host = owner_[ul];
+        if (kind == kJail) {
+            status_[pl] = kInJail;
+        }
+        else if (host == kNoOwner) {
+            int32_t price = price_[u];
+            if (money >= price && money - price >= reserve) {
+                money -= price;
+                owner_[ul] = p;
+                if (kind == kCollectable) ++collectables_[pl];
+            }
+        }
+        else if (host != p) {
+            int32_t fine;
+            if (kind == kUpgradable) fine = fines_[u * 5 + level_[ul] - 1];
+            else if (kind == kCollectable) fine = collectables_[host * kLanes + lane] * param_[u];
+            else fine = rng_[lane / kWidth].rollLane(lane % kWidth) * param_[u];
+            money_[host * kLanes + lane] += money < fine ? money : fine;
+            money -= fine;
+        }
+        else if (kind == kUpgradable && level_[ul] < 5) {
+            int32_t price = upgradePrice_[u];
+            if (money >= price && money - price >= reserve) {
+                money -= price;
+                ++level_[ul];
+            }
+        }
+        money_[pl] = money;
+
+        if (money < 0) bankrupt(lane, p);
+        else if (active_[lane] <= 1) over_[lane] = 1;
+    }
+}
+
+#ifdef BATCH_HAVE_AVX2_PATH
+namespace {
+__attribute__((target("avx2")))
+inline __m256i load(const int32_t* at) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+}
+
+__attribute__((target("avx2")))
+inline void store(int32_t* at, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(at), value);
+}
+}
+
+// stepScalar() for all lanes, kWidth at a time. Every lane-wise result is
+// computed for every lane and then blended in under the lane's mask.
+//
+// Each stage runs over all kVectors vectors before the next stage starts:
+// one vector's turn is a long chain of dependent gathers, and interleaving
+// the independent vectors keeps several chains in flight at once.
+__attribute__((target("avx2")))
+void BatchGame::stepAvx2(int p, int32_t maxTurns) {
+    constexpr int V = kVectors;
+    const int base = p * kLanes;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i seat = _mm256_set1_epi32(p);
+    const __m256i reserve = _mm256_set1_epi32(reserve_[p]);
+    const __m256i units = _mm256_set1_epi32(unitCount_);
+
+    __m256i lanes[V], over[V], status[V], move[V];
+    unsigned moving[V];
+    unsigned anyMoving = 0;
+    // Who moves: running lanes whose seat is not bankrupt; jailed seats
+    // only use up their turn.
+    for (int v = 0; v < V; ++v) {
+        const int first = v * kWidth;
+        lanes[v] = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        over[v] = load(over_ + first);
+        __m256i turns = load(turns_ + first);
+        status[v] = load(&status_[base + first]);
+        __m256i done = _mm256_or_si256(_mm256_cmpgt_epi32(over[v], zero),
+                                       _mm256_cmpgt_epi32(turns, _mm256_set1_epi32(maxTurns - 1)));
+        __m256i live = _mm256_andnot_si256(done, _mm256_xor_si256(
+            _mm256_cmpeq_epi32(status[v], _mm256_set1_epi32(kBankrupt)), _mm256_set1_epi32(-1)));
+        store(turns_ + first, _mm256_sub_epi32(turns, live));
+        __m256i jailed = _mm256_and_si256(live, _mm256_cmpeq_epi32(status[v], _mm256_set1_epi32(kInJail)));
+        move[v] = _mm256_andnot_si256(jailed, live);
+        status[v] = _mm256_blendv_epi8(status[v], _mm256_set1_epi32(kNormal), jailed);
+        moving[v] = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(move[v])));
+        anyMoving |= moving[v];
+    }
+    if (anyMoving == 0) {
+        for (int v = 0; v < V; ++v) store(&status_[base + v * kWidth], status[v]);
+        return;
+    }
+
+    // Roll and move. Each lane draws from its own stream.
+    __m256i u[V], money[V];
+    for (int v = 0; v < V; ++v) {
+        const int first = v * kWidth;
+        alignas(32) int32_t dice[kWidth];
+        rng_[v].roll(moving[v], dice);
+        __m256i die = _mm256_load_si256(reinterpret_cast<const __m256i*>(dice));
+        __m256i oldLocation = load(&location_[base + first]);
+        if (unitCount_ >= 6) {
+            // One lap at most: wrap with a compare instead of the table.
+            u[v] = _mm256_add_epi32(oldLocation, die);
+            u[v] = _mm256_sub_epi32(u[v], _mm256_andnot_si256(_mm256_cmpgt_epi32(units, u[v]), units));
+        } else {
+            u[v] = _mm256_i32gather_epi32(step_.data(), _mm256_add_epi32(_mm256_slli_epi32(oldLocation, 3), die), 4);
+        }
+        u[v] = _mm256_blendv_epi8(oldLocation, u[v], move[v]);
+        store(&location_[base + first], u[v]);
+        __m256i passed = _mm256_and_si256(move[v], _mm256_cmpgt_epi32(oldLocation, u[v]));
+        money[v] = _mm256_add_epi32(load(&money_[base + first]), _mm256_and_si256(passed, _mm256_set1_epi32(2000)));
+    }
+
+    // The unit each lane landed on, and the buy or upgrade: the
+    // ThresholdPolicy answer, lane-wise.
+    __m256i ul[V], kind[V], host[V], level[V], isJail[V], isUp[V], isCol[V], rent[V];
+    __m256i bought[V], upgraded[V];
+    __m256i anyAfford = zero;
+    for (int v = 0; v < V; ++v) {
+        ul[v] = _mm256_add_epi32(_mm256_slli_epi32(u[v], kLaneShift), lanes[v]);
+        kind[v] = _mm256_i32gather_epi32(kind_.data(), u[v], 4);
+        host[v] = _mm256_i32gather_epi32(owner_.data(), ul[v], 4);
+        level[v] = _mm256_i32gather_epi32(level_.data(), ul[v], 4);
+        __m256i price = _mm256_i32gather_epi32(price_.data(), u[v], 4);
+        __m256i upgradePrice = _mm256_i32gather_epi32(upgradePrice_.data(), u[v], 4);
+
+        isJail[v] = _mm256_and_si256(move[v], _mm256_cmpeq_epi32(kind[v], _mm256_set1_epi32(kJail)));
+        isUp[v] = _mm256_cmpeq_epi32(kind[v], _mm256_set1_epi32(kUpgradable));
+        isCol[v] = _mm256_cmpeq_epi32(kind[v], _mm256_set1_epi32(kCollectable));
+        __m256i ownable = _mm256_andnot_si256(isJail[v], move[v]);
+        __m256i unowned = _mm256_and_si256(ownable, _mm256_cmpeq_epi32(host[v], _mm256_set1_epi32(kNoOwner)));
+        __m256i mine = _mm256_and_si256(ownable, _mm256_cmpeq_epi32(host[v], seat));
+        rent[v] = _mm256_andnot_si256(_mm256_or_si256(unowned, mine), ownable);
+
+        __m256i upgrade = _mm256_and_si256(_mm256_and_si256(mine, isUp[v]),
+                                           _mm256_cmpgt_epi32(_mm256_set1_epi32(5), level[v]));
+        price = _mm256_blendv_epi8(price, upgradePrice, upgrade);
+        __m256i left = _mm256_sub_epi32(money[v], price);
+        __m256i afford = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(price, money[v]),
+                                                             _mm256_cmpgt_epi32(reserve, left)),
+                                             _mm256_or_si256(unowned, upgrade));
+        money[v] = _mm256_blendv_epi8(money[v], left, afford);
+        bought[v] = _mm256_andnot_si256(upgrade, afford);
+        upgraded[v] = _mm256_and_si256(upgrade, afford);
+        anyAfford = _mm256_or_si256(anyAfford, afford);
+        __m256i collectables = load(&collectables_[base + v * kWidth]);
+        store(&collectables_[base + v * kWidth], _mm256_sub_epi32(collectables, _mm256_and_si256(bought[v], isCol[v])));
+    }
+
+    // Rent, by kind: the level's fine, owned collectables times the unit
+    // fine, or a fresh die times the fine per point.
+    __m256i paid[V];
+    unsigned broke = 0;
+    for (int v = 0; v < V; ++v) {
+        const int first = v * kWidth;
+        __m256i isRandom = _mm256_and_si256(rent[v], _mm256_cmpeq_epi32(kind[v], _mm256_set1_epi32(kRandomCost)));
+        alignas(32) int32_t points[kWidth];
+        rng_[v].roll(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(isRandom))), points);
+        __m256i param = _mm256_i32gather_epi32(param_.data(), u[v], 4);
+        __m256i levelFine = _mm256_mask_i32gather_epi32(zero, fines_.data(),
+            _mm256_add_epi32(_mm256_mullo_epi32(u[v], _mm256_set1_epi32(5)), _mm256_sub_epi32(level[v], one)),
+            _mm256_and_si256(rent[v], isUp[v]), 4);
+        __m256i owned = _mm256_mask_i32gather_epi32(zero, collectables_.data(),
+            _mm256_add_epi32(_mm256_slli_epi32(host[v], kLaneShift), lanes[v]), _mm256_and_si256(rent[v], isCol[v]), 4);
+        __m256i fine = _mm256_mullo_epi32(param, _mm256_blendv_epi8(
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(points)), owned, isCol[v]));
+        fine = _mm256_and_si256(rent[v], _mm256_blendv_epi8(fine, levelFine, isUp[v]));
+        paid[v] = _mm256_and_si256(rent[v], _mm256_min_epi32(money[v], fine));
+        money[v] = _mm256_sub_epi32(money[v], fine);
+        store(&money_[base + first], money[v]);
+        store(&status_[base + first], _mm256_blendv_epi8(status[v], _mm256_set1_epi32(kInJail), isJail[v]));
+        broke |= (moving[v] & unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(zero, money[v]))))) << first;
+    }
+
+    // Pay the host. Seats are few, so each one takes what its lanes are
+    // owed with one masked add; a scalar loop here would store into rows
+    // that the next seat's step loads as a vector right away.
+    if (numPlayers_ <= kHostVectorSeats) {
+        for (int h = 0; h < numPlayers_; ++h) {
+            const __m256i who = _mm256_set1_epi32(h);
+            for (int v = 0; v < V; ++v) {
+                int32_t* row = &money_[h * kLanes + v * kWidth];
+                store(row, _mm256_add_epi32(load(row), _mm256_and_si256(paid[v], _mm256_cmpeq_epi32(host[v], who))));
+            }
+        }
+    } else {
+        for (int v = 0; v < V; ++v) {
+            alignas(32) int32_t hosts[kWidth];
+            alignas(32) int32_t owed[kWidth];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(hosts), host[v]);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(owed), paid[v]);
+            for (int l = 0; l < kWidth; ++l) {
+                if (owed[l]) money_[hosts[l] * kLanes + v * kWidth + l] += owed[l];
+            }
+        }
+    }
+
+    // Write back the landed-on units. AVX2 has no scatter; every lane
+    // writes, the ones with nothing to change what they read, so there is
+    // no branch on which lanes bought.
+    if (!_mm256_testz_si256(anyAfford, anyAfford)) {
+        for (int v = 0; v < V; ++v) {
+            alignas(32) int32_t at[kWidth];
+            alignas(32) int32_t owners[kWidth];
+            alignas(32) int32_t levels[kWidth];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(at), ul[v]);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(owners), _mm256_blendv_epi8(host[v], seat, bought[v]));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(levels), _mm256_sub_epi32(level[v], upgraded[v]));
+            for (int l = 0; l < kWidth; ++l) {
+                owner_[at[l]] = owners[l];
+                level_[at[l]] = levels[l];
+            }
+        }
+    }
+
+    // A lone survivor ends the game; so does the bankruptcy that leaves one.
+    for (int v = 0; v < V; ++v) {
+        __m256i alone = _mm256_and_si256(move[v], _mm256_cmpgt_epi32(_mm256_set1_epi32(2), load(active_ + v * kWidth)));
+        store(over_ + v * kWidth, _mm256_or_si256(over[v], _mm256_and_si256(alone, one)));
+    }
+    for (int lane = 0; broke; ++lane, broke >>= 1) {
+        if (broke & 1) bankrupt(lane, p);
+    }
+}
+#else
+void BatchGame::stepAvx2(int p, int32_t maxTurns) {
+    stepScalar(p, maxTurns);
+}
+#endif
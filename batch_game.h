@@ -0,0 +1,98 @@
+#ifndef BATCH_GAME__
+#define BATCH_GAME__
+
+#include <cstdint>
+#include <vector>
+
+#include "fast_game.h"
+#include "rng.h"
+
+// ================== Batch Game ==================
+// Plays kLanes games of one board in lockstep, one game per SIMD lane.
+// Every seat is a ThresholdPolicy bot, which is what lets the buy and
+// upgrade answers be computed for all lanes at once instead of through a
+// virtual call per question.
+//
+// All lanes always have the same seat to move (turn order never depends
+// on the dice), so a player's location and money for all games sit side by
+// side and load as one vector. Moving, passing "GO", the rent lookup, the
+// buy/upgrade answers, paying the host and the dice (RngLanes) are
+// lane-wise; jailed, bankrupt and finished lanes are masked off. What
+// stays scalar: writing back the units that changed hands (there is no
+// scatter in AVX2), rent to a host with more than kHostVectorSeats seats
+// at the table, and bankruptcies.
+//
+// Game i is played on dice stream i and follows exactly the turns of
+// FastGame::reset(seed, i) with the same ThresholdPolicy in every seat.
+// The vector path needs AVX2 and is picked at run time; otherwise the
+// same lockstep loop runs one lane at a time.
+class BatchGame {
+public:
+    // Games per batch: kLanes / kWidth vectors of kWidth lanes.
+    static constexpr int kLanes = 32;
+    static constexpr int kWidth = 8;
+    static constexpr int kVectors = kLanes / kWidth;
+
+    BatchGame(const BoardLayout& board, int numPlayers, int reserve = 0);
+    BatchGame(const BatchGame&) = delete;
+    BatchGame& operator=(const BatchGame&) = delete;
+
+    // The ThresholdPolicy reserve of one seat.
+    void setReserve(int seat, int reserve);
+
+    // Plays games first .. first + count - 1 (count <= kLanes, one per
+    // lane) until each is over or has started maxTurns turns.
+    void play(uint64_t seed, uint64_t first, int count, long maxTurns);
+
+    // Results of the last play(), per lane.
+    int getLaneCount() const { return count_; }
+    int getWinner(int lane) const;
+    long getTurnCount(int lane) const { return turns_[lane]; }
+    bool isOver(int lane) const { return over_[lane] != 0; }
+    int getMoney(int lane, int player) const { return money_[player * kLanes + lane]; }
+    PlayerStatus getStatus(int lane, int player) const { return PlayerStatus(status_[player * kLanes + lane]); }
+
+    // Whether play() takes the AVX2 path on this CPU.
+    static bool usesAvx2();
+
+private:
+    static constexpr int kLaneShift = 5;   // log2(kLanes)
+    // Up to this many seats rent is paid with one vector add per seat.
+    static constexpr int kHostVectorSeats = 8;
+    static_assert(kLanes == 1 << kLaneShift && kLanes % kWidth == 0);
+    static_assert(kWidth == RngLanes::kLanes);
+
+    void reset(uint64_t seed, uint64_t first, int count);
+    void stepScalar(int player, int32_t maxTurns);
+    void stepAvx2(int player, int32_t maxTurns);
+    void bankrupt(int lane, int player);
+
+    int unitCount_ = 0;
+    int numPlayers_ = 0;
+    int count_ = 0;
+
+    // The board as int32 tables, so every lookup can be a gather.
+    std::vector<int32_t> kind_;
+    std::vector<int32_t> price_;
+    std::vector<int32_t> upgradePrice_;
+    std::vector<int32_t> param_;
+    std::vector<int32_t> fines_;   // 5 per unit, level 1..5
+    std::vector<int32_t> step_;    // step_[unit * 8 + die]: where the die lands
+    std::vector<int32_t> reserve_; // per seat
+
+    // Per unit or per player, kLanes entries each: [index * kLanes + lane].
+    std::vector<int32_t> owner_;
+    std::vector<int32_t> level_;
+    std::vector<int32_t> location_;
+    std::vector<int32_t> money_;
+    std::vector<int32_t> status_;
+    std::vector<int32_t> collectables_;
+
+    // Per lane.
+    int32_t turns_[kLanes];
+    int32_t active_[kLanes];
+    int32_t over_[kLanes];
+    RngLanes rng_[kVectors];
+};
+
+#endif
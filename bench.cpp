@@ -0,0 +1,473 @@
+// Micro and macro benchmarks for the engine, with output meant to be
+// diffed between commits.
+//
+//   bench [--json] [--filter text] [--min-time S] [--repeat R]
+//
+// Every benchmark is calibrated to run for about --min-time seconds per
+// sample; the reported figure is the median of --repeat samples. Boards
+// are generated in memory and every game uses a fixed seed, so two runs
+// only differ in their timings. --json writes one object per benchmark,
+// in a fixed order, to stdout.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "batch_game.h"
+#include "fast_game.h"
+#include "game.h"
+#include "journal.h"
+#include "map.h"
+#include "map_image.h"
+#include "player.h"
+#include "policy.h"
+#include "renderer.h"
+#include "stats.h"
+
+namespace {
+
+// ================== Harness ==================
+struct Options {
+    double minTime = 0.2;
+    int repeat = 5;
+    std::string filter;
+};
+
+struct Result {
+    std::string name;
+    std::string unit;   // what one op is
+    long ops;           // per sample (calibrated, so not in the JSON)
+    double nsPerOp;     // median over samples
+};
+
+// Keeps a value alive without letting the optimizer see what happens to it.
+template <class T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Swallows output so render benchmarks measure formatting, not the terminal.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+using Body = std::function<void(long ops)>;
+
+double timeOnce(const Body& body, long ops) {
+    auto start = std::chrono::steady_clock::now();
+    body(ops);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+Result measure(const Options& options, const std::string& name, const std::string& unit, const Body& body) {
+    // Grow the op count until one sample takes about minTime.
+    long ops = 1;
+    double seconds = timeOnce(body, ops);
+    while (seconds < options.minTime && ops < (1L << 40)) {
+        double scale = seconds > 0 ? options.minTime / seconds : 100;
+        ops = long(ops * std::clamp(scale * 1.2, 2.0, 100.0));
+        seconds = timeOnce(body, ops);
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < options.repeat; ++r) {
+        samples.push_back(timeOnce(body, ops) * 1e9 / ops);
+    }
+    std::sort(samples.begin(), samples.end());
+    return Result{name, unit, ops, samples[samples.size() / 2]};
+}
+
+// ================== Boards ==================
+// The shipped map.dat, repeated and renamed to reach any size.
+std::vector<UnitSpec> makeBoard(int units) {
+    static const UnitSpec base[] = {
+        {UnitKind::Upgradable, "USA", 4000, 400, 0, {400, 800, 1200, 1600, 2000}},
+        {UnitKind::Upgradable, "Norway", 3000, 300, 0, {300, 600, 1000, 1200, 1500}},
+        {UnitKind::Upgradable, "Denmark", 4000, 400, 0, {400, 800, 1200, 1600, 2000}},
+        {UnitKind::Upgradable, "Germany", 2000, 200, 0, {200, 400, 600, 1000, 3000}},
+        {UnitKind::Upgradable, "Poland", 8000, 800, 0, {800, 2000, 3500, 4000, 4500}},
+        {UnitKind::Upgradable, "Spain", 6000, 600, 0, {600, 1200, 2000, 2500, 3500}},
+        {UnitKind::Collectable, "China", 1000, 0, 100, {}},
+        {UnitKind::RandomCost, "Taiwan", 2000, 0, 500, {}},
+        {UnitKind::Jail, "Jail", 0, 0, 0, {}},
+        {UnitKind::Collectable, "Russia", 3000, 0, 300, {}},
+        {UnitKind::Collectable, "Chile", 3000, 0, 300, {}},
+        {UnitKind::Collectable, "Peru", 3000, 0, 300, {}},
+    };
+    const int baseSize = sizeof(base) / sizeof(base[0]);
+    std::vector<UnitSpec> specs;
+    for (int u = 0; u < units; ++u) {
+        UnitSpec spec = base[u % baseSize];
+        if (u >= baseSize) spec.name += "-" + std::to_string(u / baseSize);
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+void writeMapFile(const std::string& path, const std::vector<UnitSpec>& specs) {
+    std::ofstream out(path);
+    for (const auto& spec : specs) {
+        switch (spec.kind) {
+        case UnitKind::Upgradable:
+            out << "U " << spec.name << " " << spec.price << " " << spec.upgradePrice;
+            for (int fine : spec.fines) out << " " << fine;
+            break;
+        case UnitKind::Collectable:
+            out << "C " << spec.name << " " << spec.price << " " << spec.param;
+            break;
+        case UnitKind::RandomCost:
+            out << "R " << spec.name << " " << spec.price << " " << spec.param;
+            break;
+        case UnitKind::Jail:
+            out << "J " << spec.name;
+            break;
+        }
+        out << "\n";
+    }
+}
+
+std::vector<std::string> seatNames(int numPlayers) {
+    std::vector<std::string> names;
+    for (int i = 0; i < numPlayers; ++i) names.push_back("Bot-" + std::to_string(i));
+    return names;
+}
+
+// ================== Benchmarks ==================
+class Suite {
+public:
+    explicit Suite(const Options& options) : options_(options) {}
+
+    const std::vector<Result>& getResults() const { return results_; }
+
+    void add(const std::string& name, const std::string& unit, const Body& body) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) return;
+        results_.push_back(measure(options_, name, unit, body));
+        const Result& r = results_.back();
+        std::cerr << std::left << std::setw(40) << r.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << r.nsPerOp << " ns/" << r.unit << "\n";
+    }
+
+    void visits();
+    void players();
+    void rendering();
+    void loading();
+    void games();
+
+private:
+    Options options_;
+    std::vector<Result> results_;
+};
+
+// Two players and one unit of each kind owned by each of them; every op is
+// one visit to the other player's unit, alternating sides so money flows
+// back and forth instead of draining.
+void Suite::visits() {
+    std::vector<UnitSpec> specs = {
+        {UnitKind::Upgradable, "U0", 2000, 200, 0, {200, 400, 600, 1000, 3000}},
+        {UnitKind::Upgradable, "U1", 2000, 200, 0, {200, 400, 600, 1000, 3000}},
+        {UnitKind::Collectable, "C0", 1000, 0, 100, {}},
+        {UnitKind::Collectable, "C1", 1000, 0, 100, {}},
+        {UnitKind::RandomCost, "R0", 2000, 0, 500, {}},
+        {UnitKind::RandomCost, "R1", 2000, 0, 500, {}},
+        {UnitKind::Jail, "Jail", 0, 0, 0, {}},
+        {UnitKind::Upgradable, "Free", 2000, 200, 0, {200, 400, 600, 1000, 3000}},
+    };
+    auto names = seatNames(2);
+    WorldMap map(2, specs);
+    WorldPlayer players(2, names);
+    ThresholdPolicy accept(0);
+    ThresholdPolicy decline(1 << 30);
+    Rng rng(1);
+    VisitContext ctx;
+    ctx.rng = &rng;
+
+    ctx.policy = &accept;
+    for (int u = 0; u < 6; ++u) {
+        map.getUnit(u)->onVisit(players.playerNow(u % 2), ctx);
+    }
+    ctx.policy = &decline;
+
+    auto rent = [&](int firstUnit) {
+        return [&, firstUnit](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                int side = i & 1;
+                map.getUnit(firstUnit + side)->onVisit(players.playerNow(1 - side), ctx);
+            }
+        };
+    };
+    add("visit/upgradable_rent", "visit", rent(0));
+    add("visit/collectable_rent", "visit", rent(2));
+    add("visit/random_cost_rent", "visit", rent(4));
+    add("visit/jail", "visit", [&](long ops) {
+        for (long i = 0; i < ops; ++i) {
+            map.getUnit(6)->onVisit(players.playerNow(i & 1), ctx);
+        }
+        players.playerNow(0)->releaseFromJail();
+        players.playerNow(1)->releaseFromJail();
+    });
+    add("visit/upgradable_offer_declined", "visit", [&](long ops) {
+        for (long i = 0; i < ops; ++i) {
+            map.getUnit(7)->onVisit(players.playerNow(i & 1), ctx);
+        }
+    });
+}
+
+void Suite::players() {
+    std::vector<UnitSpec> specs = makeBoard(120);
+    auto names = seatNames(1);
+    WorldMap map(1, specs);
+    WorldPlayer players(1, names);
+    Player* player = players.playerNow(0);
+    for (int u = 0; u < map.getUnitCount(); ++u) {
+        if (map.getUnit(u)->isPurchasable()) player->addUnit(map.getUnit(u));
+    }
+    add("player/num_collectable_units", "call", [&](long ops) {
+        for (long i = 0; i < ops; ++i) {
+            keep(player);
+            keep(player->getNumCollectableUnits());
+        }
+    });
+    add("player/move_to", "move", [&](long ops) {
+        for (long i = 0; i < ops; ++i) {
+            player->moveTo(int(i % map.getUnitCount()), &map);
+        }
+    });
+}
+
+// The 12-unit board keeps the original names; "/large" is a 10000-unit
+// board with 64 players, which only shows the occupied units.
+void Suite::rendering() {
+    NullBuffer sink;
+    std::ostream null(&sink);
+    struct Size {
+        const char* suffix;
+        int units;
+        int players;
+    };
+    for (Size size : {Size{"", 12, 4}, Size{"/large", 10000, 64}}) {
+        const int numPlayers = size.players;
+        std::vector<UnitSpec> specs = makeBoard(size.units);
+        auto names = seatNames(numPlayers);
+        WorldMap map(numPlayers, specs);
+        WorldPlayer players(numPlayers, names);
+        for (int i = 0; i < numPlayers; ++i) {
+            map.getUnit(0)->addPlayerHere(players.playerNow(i));
+        }
+        TerminalRenderer renderer(null);
+        std::string suffix = size.suffix;
+
+        add("render/unit_display" + suffix, "unit", [&](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                std::string text = map.getUnit(int(i % map.getUnitCount()))->display();
+                keep(text);
+            }
+        });
+        add("render/board_full" + suffix, "frame", [&](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                renderer.invalidate();
+                renderer.draw(map, players, 0);
+            }
+        });
+        // The usual frame: one player moved since the last draw.
+        add("render/board_incremental" + suffix, "frame", [&](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                int seat = int(i % numPlayers);
+                Player* p = players.playerNow(seat);
+                p->moveTo((p->getLocation() + 1) % map.getUnitCount(), &map);
+                renderer.draw(map, players, seat);
+            }
+        });
+        // The same frame as the game thread sees it with a RenderThread:
+        // capture only, the drawing (or skipping) happens on the other side.
+        add("render/publish" + suffix, "frame", [&](long ops) {
+            RenderThread display(null);
+            for (long i = 0; i < ops; ++i) {
+                int seat = int(i % numPlayers);
+                Player* p = players.playerNow(seat);
+                p->moveTo((p->getLocation() + 1) % map.getUnitCount(), &map);
+                display.publish(map, players, seat);
+            }
+        });
+    }
+}
+
+void Suite::loading() {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path();
+    struct Size {
+        const char* label;
+        int units;
+    };
+    for (Size size : {Size{"small", 12}, Size{"large", 10000}}) {
+        std::vector<UnitSpec> specs = makeBoard(size.units);
+        std::string text = (dir / ("bench-map-" + std::string(size.label) + ".dat")).string();
+        std::string bin = (dir / ("bench-map-" + std::string(size.label) + ".bin")).string();
+        writeMapFile(text, specs);
+        std::string error;
+        MapImage::write(bin, specs, error);
+
+        std::string suffix = std::string("/") + size.label;
+        add("load/parse_map_dat" + suffix, "file", [&](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                std::vector<UnitSpec> parsed;
+                std::vector<std::string> errors;
+                parseMapFile(text, parsed, errors);
+                keep(parsed);
+            }
+        });
+        add("load/open_image" + suffix, "file", [&](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                MapImage image;
+                std::string openError;
+                image.open(bin, openError);
+                keep(image);
+            }
+        });
+        add("load/build_world_map" + suffix, "map", [&](long ops) {
+            for (long i = 0; i < ops; ++i) {
+                WorldMap map(4, specs);
+                keep(map);
+            }
+        });
+        fs::remove(text);
+        fs::remove(bin);
+    }
+}
+
+// Headless play with buy-everything bots. Turns restart the game whenever
+// it ends or reaches the cap; games are played to the end or the cap.
+// Two seats is the smallest real game: with one, it ends after a turn.
+void Suite::games() {
+    const long kTurnCap = 1000;
+    struct Size {
+        const char* label;
+        int units;
+    };
+    ThresholdPolicy policy(0);
+    for (Size size : {Size{"small", 12}, Size{"large", 1000}}) {
+        std::vector<UnitSpec> specs = makeBoard(size.units);
+        BoardLayout layout(specs);
+        for (int numPlayers : {2, 4, 32}) {
+            auto names = seatNames(numPlayers);
+            WorldMap map(numPlayers, specs);
+            WorldPlayer players(numPlayers, names);
+            Game game(map, players, 1);
+            FastGame fast(layout, numPlayers, 1);
+            BatchGame batch(layout, numPlayers, 0);
+            for (int i = 0; i < numPlayers; ++i) {
+                game.setPolicy(i, &policy);
+                fast.setPolicy(i, &policy);
+            }
+
+            std::string suffix = "/p" + std::to_string(numPlayers) + "/" + size.label;
+            uint64_t seed = 1;
+            add("game/turns" + suffix, "turn", [&](long ops) {
+                for (long i = 0; i < ops; ++i) {
+                    if (game.isOver() || game.getTurnCount() >= kTurnCap) game.reset(seed++);
+                    game.playTurn();
+                }
+            });
+            // The same turns recorded to a journal on /dev/null: the
+            // difference to game/turns is the cost of journaling.
+            JournalWriter journal;
+            journal.open("/dev/null", game, seed);
+            add("game/journaled_turns" + suffix, "turn", [&](long ops) {
+                game.setJournal(&journal);
+                for (long i = 0; i < ops; ++i) {
+                    if (game.isOver() || game.getTurnCount() >= kTurnCap) game.reset(seed++);
+                    game.playTurn();
+                }
+                game.setJournal(nullptr);
+            });
+            add("fast_game/turns" + suffix, "turn", [&](long ops) {
+                for (long i = 0; i < ops; ++i) {
+                    if (fast.isOver() || fast.getTurnCount() >= kTurnCap) fast.reset(seed++);
+                    fast.playTurn();
+                }
+            });
+            // The same turns counted into GameStats: the difference to
+            // fast_game/turns is the cost of statistics.
+            GameStats stats(layout.unitCount, numPlayers);
+            add("fast_game/stats_turns" + suffix, "turn", [&](long ops) {
+                fast.setStats(&stats);
+                for (long i = 0; i < ops; ++i) {
+                    if (fast.isOver() || fast.getTurnCount() >= kTurnCap) fast.reset(seed++);
+                    fast.playTurn();
+                }
+                fast.setStats(nullptr);
+            });
+            add("game/games" + suffix, "game", [&](long ops) {
+                for (long i = 0; i < ops; ++i) {
+                    game.reset(seed++);
+                    keep(game.runToCompletion(kTurnCap));
+                }
+            });
+            add("fast_game/games" + suffix, "game", [&](long ops) {
+                for (long i = 0; i < ops; ++i) {
+                    fast.reset(seed++);
+                    keep(fast.runToCompletion(kTurnCap));
+                }
+            });
+            // The same games kLanes at a time, in lockstep.
+            add("batch_game/games" + suffix, "game", [&](long ops) {
+                for (long i = 0; i < ops; i += BatchGame::kLanes) {
+                    int count = int(std::min<long>(BatchGame::kLanes, ops - i));
+                    batch.play(seed, 0, count, kTurnCap);
+                    keep(batch.getWinner(0));
+                    ++seed;
+                }
+            });
+        }
+    }
+}
+
+void printJson(const std::vector<Result>& results) {
+    std::cout << "{\n  \"schema\": 1,\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::cout << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit
+                  << "\"" << std::fixed << std::setprecision(3)
+                  << ", \"ns_per_op\": " << r.nsPerOp
+                  << ", \"ops_per_sec\": " << std::setprecision(1) << 1e9 / r.nsPerOp << "}"
+                  << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--json") json = true;
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--min-time" && hasValue) options.minTime = std::atof(argv[++i]);
+        else if (arg == "--repeat" && hasValue) options.repeat = std::atoi(argv[++i]);
+        else {
+            std::cerr << "usage: bench [--json] [--filter text] [--min-time S] [--repeat R]\n";
+            return 1;
+        }
+    }
+    if (options.repeat < 1) options.repeat = 1;
+
+    Suite suite(options);
+    suite.visits();
+    suite.players();
+    suite.rendering();
+    suite.loading();
+    suite.games();
+
+    if (json) printJson(suite.getResults());
+    return 0;
+}
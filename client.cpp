@@ -0,0 +1,226 @@
+// Test client for the game server: plays many tables at once over one
+// connection, or opens idle tables to measure the server's footprint.
+//
+//   client [-s monopoly.sock] [-n tables] [-p players] [--max-turns N] [--idle]
+//
+// Play mode keeps one request in flight per table (every table rolls,
+// answers YES to every offer, and closes when its game ends or hits the
+// turn cap) and reports request round-trip latency and turns per second.
+// --idle only creates the tables and prints the server's STATS line.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class LineSocket {
+public:
+    bool connect(const std::string& path) {
+        fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        return fd_ >= 0 && ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+    ~LineSocket() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    void queue(const std::string& line) { out_ += line + "\n"; }
+
+    bool flush() {
+        size_t sent = 0;
+        while (sent < out_.size()) {
+            ssize_t n = send(fd_, out_.data() + sent, out_.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
+        }
+        out_.clear();
+        return true;
+    }
+
+    // Blocks until at least one full line is buffered.
+    bool readLine(std::string& line) {
+        size_t end;
+        while ((end = in_.find('\n', pos_)) == std::string::npos) {
+            if (pos_ > 0) {
+                in_.erase(0, pos_);
+                pos_ = 0;
+            }
+            char buf[65536];
+            ssize_t n = read(fd_, buf, sizeof(buf));
+            if (n <= 0) return false;
+            in_.append(buf, n);
+        }
+        line.assign(in_, pos_, end - pos_);
+        pos_ = end + 1;
+        return true;
+    }
+
+    bool hasBufferedLine() const { return in_.find('\n', pos_) != std::string::npos; }
+
+private:
+    int fd_ = -1;
+    std::string in_;
+    size_t pos_ = 0;
+    std::string out_;
+};
+
+struct TableState {
+    Clock::time_point sent;
+    long turns = 0;
+    bool finished = false;
+    bool closing = false;
+};
+
+double percentileUs(std::vector<double>& samples, double q) {
+    if (samples.empty()) return 0;
+    size_t k = std::min(samples.size() - 1, size_t(q * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string socketPath = "monopoly.sock";
+    int numTables = 1000;
+    int numPlayers = 4;
+    long maxTurns = 500;
+    bool idle = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-s" && hasValue) socketPath = argv[++i];
+        else if (arg == "-n" && hasValue) numTables = std::atoi(argv[++i]);
+        else if (arg == "-p" && hasValue) numPlayers = std::atoi(argv[++i]);
+        else if (arg == "--max-turns" && hasValue) maxTurns = std::atol(argv[++i]);
+        else if (arg == "--idle") idle = true;
+        else {
+            std::cerr << "usage: client [-s monopoly.sock] [-n tables] [-p players] [--max-turns N] [--idle]\n";
+            return 1;
+        }
+    }
+
+    LineSocket sock;
+    if (!sock.connect(socketPath)) {
+        std::cerr << socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // Open every table first; their ids come back in order.
+    for (int t = 0; t < numTables; ++t) {
+        sock.queue("NEW " + std::to_string(numPlayers) + " " + std::to_string(t + 1));
+    }
+    sock.flush();
+    std::unordered_map<int, TableState> tables;
+    std::vector<int> ids;
+    std::string line;
+    for (int t = 0; t < numTables; ++t) {
+        if (!sock.readLine(line)) return 1;
+        int id = 0;
+        if (std::sscanf(line.c_str(), "TABLE %d", &id) != 1) {
+            std::cerr << "unexpected reply: " << line << "\n";
+            return 1;
+        }
+        tables[id];
+        ids.push_back(id);
+    }
+
+    if (idle) {
+        sock.queue("STATS");
+        sock.flush();
+        if (!sock.readLine(line)) return 1;
+        std::cout << numTables << " idle tables: " << line << "\n";
+        return 0;
+    }
+
+    auto start = Clock::now();
+    for (int id : ids) {
+        tables[id].sent = Clock::now();
+        sock.queue("ROLL " + std::to_string(id));
+    }
+    sock.flush();
+
+    std::vector<double> latencies;
+    long turns = 0, games = 0;
+    size_t open = ids.size();
+    while (open > 0 && sock.readLine(line)) {
+        std::istringstream reply(line);
+        std::string kind;
+        int id = 0;
+        reply >> kind >> id;
+        auto it = tables.find(id);
+        if (it == tables.end()) {
+            std::cerr << "unexpected reply: " << line << "\n";
+            return 1;
+        }
+        TableState& table = it->second;
+        auto now = Clock::now();
+
+        if (kind == "ASK") {
+            latencies.push_back(std::chrono::duration<double, std::micro>(now - table.sent).count());
+            table.sent = now;
+            sock.queue("ANSWER " + std::to_string(id) + " YES");
+        }
+        else if (kind == "TURN" || kind == "SKIP") {
+            latencies.push_back(std::chrono::duration<double, std::micro>(now - table.sent).count());
+            ++turns;
+            if (++table.turns >= maxTurns) {
+                table.closing = true;
+                sock.queue("CLOSE " + std::to_string(id));
+            } else {
+                table.sent = now;
+                sock.queue("ROLL " + std::to_string(id));
+            }
+        }
+        else if (kind == "OVER") {
+            // Follows the TURN that ended the game, after which a ROLL was
+            // already sent; that one is answered with OVER too.
+            if (!table.finished) {
+                table.finished = true;
+                ++games;
+            }
+            if (!table.closing) {
+                table.closing = true;
+                sock.queue("CLOSE " + std::to_string(id));
+            }
+        }
+        else if (kind == "CLOSED") {
+            --open;
+        }
+        else {
+            std::cerr << "unexpected reply: " << line << "\n";
+            return 1;
+        }
+        // Batch replies that are already here into one write.
+        if (!sock.hasBufferedLine()) sock.flush();
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << numTables << " tables, " << turns << " turns, " << games << " finished games in "
+              << seconds << " s (" << turns / seconds << " turns/s)\n";
+    std::cout << std::setprecision(1) << "round trip us: p50 " << percentileUs(latencies, 0.50)
+              << "  p99 " << percentileUs(latencies, 0.99) << "  max " << percentileUs(latencies, 1.0) << "\n";
+
+    sock.queue("STATS");
+    sock.flush();
+    if (sock.readLine(line)) std::cout << line << "\n";
+    return 0;
+}
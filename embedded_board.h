@@ -0,0 +1,47 @@
+// Generated by `mapc --header map.dat embedded_board.h`; do not edit.
+#ifndef EMBEDDED_BOARD__
+#define EMBEDDED_BOARD__
+
+#include <cstdint>
+
+#include "map.h"
+
+struct EmbeddedBoard {
+    static constexpr int kUnitCount = 12;
+    static constexpr UnitKind kKind[kUnitCount] = {
+        UnitKind::Upgradable, UnitKind::Upgradable, UnitKind::Upgradable, UnitKind::Upgradable, UnitKind::Upgradable, UnitKind::Upgradable, UnitKind::Collectable, UnitKind::RandomCost,
+        UnitKind::Jail, UnitKind::Collectable, UnitKind::Collectable, UnitKind::Collectable,
+    };
+    static constexpr int32_t kPrice[kUnitCount] = {
+        4000, 3000, 4000, 2000, 8000, 6000, 1000, 2000,
+        0, 3000, 3000, 3000,
+    };
+    static constexpr int32_t kUpgradePrice[kUnitCount] = {
+        400, 300, 400, 200, 800, 600, 0, 0,
+        0, 0, 0, 0,
+    };
+    static constexpr int32_t kParam[kUnitCount] = {
+        0, 0, 0, 0, 0, 0, 100, 500,
+        0, 300, 300, 300,
+    };
+    static constexpr int32_t kFines[kUnitCount][5] = {
+        {400, 800, 1200, 1600, 2000},
+        {300, 600, 1000, 1200, 1500},
+        {400, 800, 1200, 1600, 2000},
+        {200, 400, 600, 1000, 3000},
+        {800, 2000, 3500, 4000, 4500},
+        {600, 1200, 2000, 2500, 3500},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+    };
+    static constexpr const char* kName[kUnitCount] = {
+        "USA", "Norway", "Denmark", "Germany", "Poland", "Spain", "China", "Taiwan",
+        "Jail", "Russian", "test", "test2",
+    };
+};
+
+#endif
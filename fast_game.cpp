@@ -0,0 +1,415 @@
+#include "fast_game.h"
+#include "stats.h"
+#include "zobrist.h"
+#include <algorithm>
+
+
+namespace {
+// Round-start states remembered per game; the table starts over when half
+// full, which only a long game that is not stalling gets to.
+const int kStallSlots = 1024;
+}
+
+
+// ================== Board Layout ==================
+BoardLayout::BoardLayout(const WorldMap& map) {
+    std::vector<UnitSpec> specs(map.getUnitCount());
+    for (int u = 0; u < map.getUnitCount(); ++u) {
+        const MapUnit* unit = map.getUnit(u);
+        UnitSpec& spec = specs[u];
+        spec.kind = unit->kind();
+        if (spec.kind == UnitKind::Upgradable) {
+            auto* up = static_cast<const UpgradableUnit*>(unit);
+            spec.price = up->getPrice();
+            spec.upgradePrice = up->getUpgradePrice();
+            for (int level = 1; level <= 5; ++level) {
+                spec.fines[level - 1] = up->getFineAtLevel(level);
+            }
+        }
+        else if (spec.kind == UnitKind::Collectable) {
+            auto* c = static_cast<const CollectableUnit*>(unit);
+            spec.price = c->getPrice();
+            spec.param = c->getUnitFine();
+        }
+        else if (spec.kind == UnitKind::RandomCost) {
+            auto* r = static_cast<const RandomCostUnit*>(unit);
+            spec.price = r->getPrice();
+            spec.param = r->getFinePerPoint();
+        }
+    }
+    adopt(specs);
+}
+
+BoardLayout::BoardLayout(const std::vector<UnitSpec>& specs) {
+    adopt(specs);
+}
+
+BoardLayout::BoardLayout(const MapImage& image)
+    : unitCount(image.getUnitCount()),
+      kind(image.kinds()), price(image.prices()), upgradePrice(image.upgradePrices()),
+      param(image.params()), fines(image.fines()) {}
+
+uint32_t BoardLayout::fingerprint() const {
+    uint32_t hash = kFingerprintSeed;
+    for (int u = 0; u < unitCount; ++u) {
+        hash = fingerprintUnit(hash, static_cast<int>(kind[u]), kind[u] == UnitKind::Jail ? 0 : price[u]);
+    }
+    return hash;
+}
+
+// Copies specs into owned storage: one array of kinds and one int block
+// holding price | upgradePrice | param | fines back to back.
+void BoardLayout::adopt(const std::vector<UnitSpec>& specs) {
+    const int n = specs.size();
+    unitCount = n;
+    kindStore_.resize(n);
+    intStore_.assign(n * 8, 0);
+    int32_t* prices = intStore_.data();
+    int32_t* upgrades = prices + n;
+    int32_t* params = upgrades + n;
+    int32_t* fineTable = params + n;
+    for (int u = 0; u < n; ++u) {
+        kindStore_[u] = specs[u].kind;
+        prices[u] = specs[u].price;
+        upgrades[u] = specs[u].upgradePrice;
+        params[u] = specs[u].param;
+        for (int l = 0; l < 5; ++l) fineTable[u * 5 + l] = specs[u].fines[l];
+    }
+    kind = kindStore_.data();
+    price = prices;
+    upgradePrice = upgrades;
+    param = params;
+    fines = fineTable;
+}
+
+// ================== Fast Game ==================
+FastGame::FastGame(const BoardLayout& board, int numPlayers, uint64_t seed, uint64_t stream) {
+    rebind(board, numPlayers);
+    reset(seed, stream);
+}
+
+void FastGame::rebind(const BoardLayout& board, int numPlayers) {
+    const size_t units = board.unitCount;
+    const size_t players = numPlayers;
+    arena_.reserve(Arena::footprint<UnitState>(units) +
+                   Arena::footprint<int32_t>(players) * 3 +
+                   Arena::footprint<uint8_t>(players) +
+                   Arena::footprint<DecisionPolicy*>(players));
+    units_ = arena_.allocate<UnitState>(units);
+    location_ = arena_.allocate<int32_t>(players);
+    money_ = arena_.allocate<int32_t>(players);
+    collectables_ = arena_.allocate<int32_t>(players);
+    status_ = arena_.allocate<uint8_t>(players);
+    policies_ = arena_.allocate<DecisionPolicy*>(players);
+
+    board_ = &board;
+    numPlayers_ = numPlayers;
+    // Fresh memory: make every unit stale for any epoch but the first.
+    epoch_ = 0;
+    std::fill(units_, units_ + units, UnitState{0, kNoOwner, 1});
+    std::fill(policies_, policies_ + players, nullptr);
+}
+
+void FastGame::reset(uint64_t seed, uint64_t stream) {
+    // Every unit written in the last game now carries an old epoch and so
+    // reads as unowned. Clear for real once in 2^32 games when it wraps.
+    if (++epoch_ == 0) {
+        std::fill(units_, units_ + board_->unitCount, UnitState{0, kNoOwner, 1});
+        epoch_ = 1;
+    }
+    std::fill(location_, location_ + numPlayers_, 0);
+    std::fill(money_, money_ + numPlayers_, 30000);
+    std::fill(status_, status_ + numPlayers_, uint8_t(PlayerStatus::Normal));
+    std::fill(collectables_, collectables_ + numPlayers_, 0);
+    rng_.seed(seed, stream);
+    current_ = 0;
+    activePlayers_ = numPlayers_;
+    turns_ = 0;
+    over_ = false;
+    unitHash_ = 0;
+    stalled_ = false;
+    stallUsed_ = kStallSlots;   // the first round start clears the table
+}
+
+void FastGame::setPolicy(int playerIndex, DecisionPolicy* policy) {
+    if (playerIndex >= 0 && playerIndex < numPlayers_) {
+        policies_[playerIndex] = policy;
+    }
+}
+
+void FastGame::playTurn() {
+    const int p = current_;
+
+    if (status_[p] == uint8_t(PlayerStatus::Bankrupt)) {
+        advance();
+        return;
+    }
+    ++turns_;
+    if (status_[p] == uint8_t(PlayerStatus::InJail)) {
+        status_[p] = uint8_t(PlayerStatus::Normal);
+        advance();
+        return;
+    }
+
+    int oldLocation = location_[p];
+    int newLocation = oldLocation + rng_.rollDie();
+    if (newLocation >= board_->unitCount) {
+        newLocation %= board_->unitCount;
+    }
+    // Passing "GO" pays the same reward as Game.
+    if (newLocation < oldLocation) {
+        money_[p] += 2000;
+    }
+    location_[p] = newLocation;
+    if (stats_) stats_->land(newLocation);
+
+    visit(p, newLocation);
+    endTurn(p);
+}
+
+void FastGame::resumeTurn(const Decision& decision, bool accept) {
+    const int p = decision.playerId;
+    if (accept && money_[p] >= decision.price) {
+        money_[p] -= decision.price;
+        UnitState& unit = claim(decision.unitId);
+        if (decision.kind == DecisionKind::Buy) {
+            setOwner(unit, decision.unitId, p);
+            if (board_->kind[decision.unitId] == UnitKind::Collectable) {
+                ++collectables_[p];
+            }
+        } else if (unit.level < 5) {
+            raiseLevel(unit, decision.unitId);
+        }
+    }
+    endTurn(p);
+}
+
+// Bankruptcy check and hand-over to the next seat, as in Game::finishTurn.
+void FastGame::endTurn(int p) {
+    if (money_[p] < 0) {
+        bankrupt(p);
+        --activePlayers_;
+    }
+    advance();
+    if (activePlayers_ <= 1) {
+        over_ = true;
+    }
+}
+
+void FastGame::advance() {
+    current_ = (current_ + 1) % numPlayers_;
+}
+
+void FastGame::reseedDice(uint64_t seed, uint64_t stream) {
+    rng_.seed(seed, stream);
+}
+
+int FastGame::runToCompletion(long maxTurns) {
+    if (stallLimit_ <= 0) {
+        while (!over_ && turns_ < maxTurns) {
+            playTurn();
+        }
+        return getLeader();
+    }
+    while (!over_ && turns_ < maxTurns) {
+        playTurn();
+        if (current_ == 0 && repeatsRound()) {
+            stalled_ = true;
+            break;
+        }
+    }
+    return getLeader();
+}
+
+uint64_t FastGame::getHash(bool withLocations) const {
+    uint64_t h = unitHash_ ^ zobrist::key(zobrist::ToMove, current_);
+    for (int p = 0; p < numPlayers_; ++p) {
+        h ^= zobrist::playerKey(p, location_[p], money_[p], status_[p], withLocations);
+    }
+    return h;
+}
+
+// Counts this round start's state; true once it has come up stallLimit_
+// times.
+bool FastGame::repeatsRound() {
+    if (stallUsed_ >= kStallSlots / 2) {
+        if (stallSlots_.size() != size_t(kStallSlots)) stallSlots_.assign(kStallSlots, StallSlot{0, 0, 0});
+        if (++stallEpoch_ == 0) {
+            std::fill(stallSlots_.begin(), stallSlots_.end(), StallSlot{0, 0, 0});
+            stallEpoch_ = 1;
+        }
+        stallUsed_ = 0;
+    }
+    const uint64_t hash = getHash(false);
+    for (size_t i = hash & (kStallSlots - 1);; i = (i + 1) & (kStallSlots - 1)) {
+        StallSlot& slot = stallSlots_[i];
+        if (slot.epoch != stallEpoch_) {
+            slot = StallSlot{hash, stallEpoch_, 1};
+            ++stallUsed_;
+            return stallLimit_ <= 1;
+        }
+        if (slot.hash == hash) return ++slot.count >= uint32_t(stallLimit_);
+    }
+}
+
+void FastGame::setOwner(UnitState& state, int unit, int owner) {
+    unitHash_ ^= zobrist::ownerKey(unit, state.owner) ^ zobrist::ownerKey(unit, owner);
+    state.owner = int16_t(owner);
+}
+
+void FastGame::raiseLevel(UnitState& state, int unit) {
+    unitHash_ ^= zobrist::levelKey(unit, state.level) ^ zobrist::levelKey(unit, state.level + 1);
+    ++state.level;
+}
+
+bool FastGame::save(GameState& state) const {
+    if (numPlayers_ > kMaxStatePlayers || board_->unitCount > kMaxStateUnits) return false;
+    state.reset(numPlayers_, board_->unitCount);
+    state.boardFingerprint = board_->fingerprint();
+    state.currentPlayer = current_;
+    state.activePlayers = activePlayers_;
+    state.over = over_;
+    state.turns = turns_;
+    rng_.savePosition(state.rngKey, state.rngCounter, state.rngPosition);
+    for (int p = 0; p < numPlayers_; ++p) {
+        state.players[p].money = money_[p];
+        state.players[p].location = location_[p];
+        state.players[p].status = status_[p];
+    }
+    for (int u = 0; u < board_->unitCount; ++u) {
+        state.units[u].owner = getOwner(u);
+        state.units[u].level = int8_t(getLevel(u));
+    }
+    return true;
+}
+
+bool FastGame::restore(const GameState& state) {
+    if (!isStateConsistent(state) || int(state.playerCount) != numPlayers_ ||
+        int(state.unitCount) != board_->unitCount || state.boardFingerprint != board_->fingerprint()) {
+        return false;
+    }
+    if (++epoch_ == 0) epoch_ = 1;
+    std::fill(collectables_, collectables_ + numPlayers_, 0);
+    unitHash_ = 0;
+    for (int u = 0; u < board_->unitCount; ++u) {
+        UnitState& unit = units_[u];
+        unit.epoch = epoch_;
+        unit.owner = state.units[u].owner;
+        unit.level = state.units[u].level;
+        unitHash_ ^= zobrist::ownerKey(u, unit.owner) ^ zobrist::levelKey(u, unit.level);
+        if (unit.owner != kNoOwner && board_->kind[u] == UnitKind::Collectable) {
+            ++collectables_[unit.owner];
+        }
+    }
+    for (int p = 0; p < numPlayers_; ++p) {
+        money_[p] = state.players[p].money;
+        location_[p] = state.players[p].location;
+        status_[p] = state.players[p].status;
+    }
+    current_ = state.currentPlayer;
+    activePlayers_ = state.activePlayers;
+    over_ = state.over;
+    turns_ = state.turns;
+    rng_.restorePosition(state.rngKey, state.rngCounter, state.rngPosition);
+    stalled_ = false;
+    stallUsed_ = kStallSlots;
+    return true;
+}
+
+int FastGame::getLeader() const {
+    int leader = -1;
+    for (int i = 0; i < numPlayers_; ++i) {
+        if (status_[i] == uint8_t(PlayerStatus::Bankrupt)) continue;
+        if (leader < 0 || money_[i] > money_[leader]) {
+            leader = i;
+        }
+    }
+    return leader;
+}
+
+void FastGame::visit(int p, int u) {
+    const BoardLayout& board = *board_;
+    UnitState& unit = claim(u);
+    const int host = unit.owner;
+    switch (board.kind[u]) {
+    case UnitKind::Upgradable:
+        if (host == kNoOwner) {
+            if (offer(DecisionKind::Buy, p, u, board.price[u], 1)) {
+                setOwner(unit, u, p);
+            }
+        }
+        else if (host != p) {
+            payRent(p, u, host, board.fineAt(u, unit.level));
+        }
+        else if (unit.level < 5) {
+            if (offer(DecisionKind::Upgrade, p, u, board.upgradePrice[u], unit.level)) {
+                raiseLevel(unit, u);
+            }
+        }
+        break;
+    case UnitKind::Collectable:
+        if (host == kNoOwner) {
+            if (offer(DecisionKind::Buy, p, u, board.price[u], 1)) {
+                setOwner(unit, u, p);
+                ++collectables_[p];
+            }
+        }
+        else if (host != p) {
+            payRent(p, u, host, collectables_[host] * board.param[u]);
+        }
+        break;
+    case UnitKind::RandomCost:
+        if (host == kNoOwner) {
+            if (offer(DecisionKind::Buy, p, u, board.price[u], 1)) {
+                setOwner(unit, u, p);
+            }
+        }
+        else if (host != p) {
+            payRent(p, u, host, rng_.rollDie() * board.param[u]);
+        }
+        break;
+    case UnitKind::Jail:
+        status_[p] = uint8_t(PlayerStatus::InJail);
+        break;
+    }
+}
+
+// Asks the seat's policy when the player can afford the price; charges the
+// price when accepted.
+bool FastGame::offer(DecisionKind kind, int p, int u, int price, int level) {
+    if (money_[p] < price) return false;
+    Decision decision;
+    decision.kind = kind;
+    decision.playerId = p;
+    decision.unitId = u;
+    decision.money = money_[p];
+    decision.price = price;
+    decision.level = level;
+    bool accepted = policies_[p]->decide(decision);
+    if (stats_) stats_->offer(kind, u, level, accepted);
+    if (!accepted) return false;
+    money_[p] -= price;
+    return true;
+}
+
+// Same semantics as Player::pay: the debtor goes negative by the full fine,
+// the host only receives what the debtor actually had.
+void FastGame::payRent(int p, int u, int host, int fine) {
+    int payment = money_[p] < fine ? money_[p] : fine;
+    money_[p] -= fine;
+    money_[host] += payment;
+    if (stats_) stats_->rent(u, payment);
+}
+
+void FastGame::bankrupt(int p) {
+    if (stats_) stats_->bankrupt(turns_);
+    status_[p] = uint8_t(PlayerStatus::Bankrupt);
+    for (int u = 0; u < board_->unitCount; ++u) {
+        if (live(u) && units_[u].owner == p) {
+            unitHash_ ^= zobrist::ownerKey(u, p) ^ zobrist::levelKey(u, units_[u].level);
+            units_[u].owner = kNoOwner;
+            units_[u].level = 1;
+        }
+    }
+    collectables_[p] = 0;
+}
@@ -0,0 +1,191 @@
+#ifndef FAST_GAME__
+#define FAST_GAME__
+
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "game_state.h"
+#include "map.h"
+#include "map_image.h"
+#include "player.h"
+#include "policy.h"
+#include "rng.h"
+
+class GameStats;
+
+// ================== Board Layout ==================
+// The immutable part of a board as struct-of-arrays: everything the hot
+// "move, look up unit, charge rent" loop reads sits in a few contiguous
+// arrays indexed by unit id. Built once and shared by any number of games.
+// A layout either owns its arrays or, when built from a MapImage, points
+// straight into the mapped file (the image must then outlive it).
+class BoardLayout {
+public:
+    explicit BoardLayout(const WorldMap& map);
+    explicit BoardLayout(const std::vector<UnitSpec>& specs);
+    explicit BoardLayout(const MapImage& image);
+    BoardLayout(const BoardLayout&) = delete;
+    BoardLayout& operator=(const BoardLayout&) = delete;
+
+    int unitCount = 0;
+    const UnitKind* kind = nullptr;
+    const int32_t* price = nullptr;
+    const int32_t* upgradePrice = nullptr;
+    const int32_t* param = nullptr;   // unitFine (C) or finePerPoint (R)
+    const int32_t* fines = nullptr;   // 5 per unit, level 1..5 (U only)
+
+    int32_t fineAt(int unit, int level) const { return fines[unit * 5 + level - 1]; }
+    uint32_t fingerprint() const;
+
+private:
+    void adopt(const std::vector<UnitSpec>& specs);
+
+    std::vector<UnitKind> kindStore_;
+    std::vector<int32_t> intStore_;
+};
+
+// ================== Fast Game ==================
+// Headless engine over a BoardLayout. Same rules, same dice stream and same
+// policy calls as Game, but every piece of mutable state is a flat array
+// and the visit is a switch on the unit kind instead of a virtual call.
+// Display stays with the MapUnit classes; this is for simulation only.
+//
+// All mutable per-game state lives in one arena: constructing a game is a
+// single allocation, and reset() starts a new game in O(players) by bumping
+// an epoch instead of clearing every unit. A worker thread keeps one
+// FastGame and reuses it for every game it plays, even on another board.
+class FastGame {
+public:
+    static constexpr int16_t kNoOwner = -1;
+
+    FastGame(const BoardLayout& board, int numPlayers, uint64_t seed = 0, uint64_t stream = 0);
+    FastGame(const FastGame&) = delete;
+    FastGame& operator=(const FastGame&) = delete;
+
+    // Moves this context to another board and/or seat count. The arena is
+    // only reallocated when the new game needs more room.
+    void rebind(const BoardLayout& board, int numPlayers);
+
+    void reset(uint64_t seed, uint64_t stream = 0);
+    void setPolicy(int playerIndex, DecisionPolicy* policy);
+    // Landings, rent, offers and bankruptcies go to `stats` (nullptr for
+    // none). The caller records the end of each game.
+    void setStats(GameStats* stats) { stats_ = stats; }
+
+    void playTurn();
+
+    // Finishes a turn whose snapshot was taken while `decision` waited for
+    // an answer (the mover is still the current player): applies the answer
+    // and runs the end-of-turn checks. Used to branch lookahead from a
+    // decision point.
+    void resumeTurn(const Decision& decision, bool accept);
+
+    // New dice for the rest of the game without touching the board, so
+    // rollouts from one snapshot don't all see the same future.
+    void reseedDice(uint64_t seed, uint64_t stream);
+    // Plays until one player is left, maxTurns turns were started or the
+    // game stalled. Returns the id of the richest active player.
+    int runToCompletion(long maxTurns);
+
+    // Zobrist hash of the game (see zobrist.h), equal to hashState() of a
+    // save(). Owners and levels are hashed as they change; the handful of
+    // per-player features, which change every turn, are added here.
+    uint64_t getHash(bool withLocations = true) const;
+
+    // With a limit, runToCompletion() gives up on a game once the state at
+    // the start of a round, locations left out, has come up `repeats`
+    // times: only the pieces are moving, or the same few states keep
+    // coming back. 0 (the default) never gives up.
+    void setStallLimit(int repeats) { stallLimit_ = repeats; }
+    bool isStalled() const { return stalled_; }
+
+    bool isOver() const { return over_; }
+    long getTurnCount() const { return turns_; }
+    int getCurrentPlayerIndex() const { return current_; }
+    int getActivePlayers() const { return activePlayers_; }
+    int getPlayerCount() const { return numPlayers_; }
+    int getLeader() const;
+
+    int getMoney(int player) const { return money_[player]; }
+    int getLocation(int player) const { return location_[player]; }
+    PlayerStatus getStatus(int player) const { return PlayerStatus(status_[player]); }
+    int getOwner(int unit) const { return live(unit) ? units_[unit].owner : kNoOwner; }
+    int getLevel(int unit) const { return live(unit) ? units_[unit].level : 1; }
+    size_t getArenaBytes() const { return arena_.getCapacity(); }
+
+    // Same snapshot format as Game, so a state saved by either engine can
+    // be restored into the other. Cheap enough to clone a game per rollout.
+    bool save(GameState& state) const;
+    bool restore(const GameState& state);
+
+private:
+    // Owner and level of a unit, valid only while epoch matches the game's:
+    // a stale entry reads as "unowned, level 1".
+    struct UnitState {
+        uint32_t epoch;
+        int16_t owner;
+        int8_t level;
+    };
+
+    bool live(int unit) const { return units_[unit].epoch == epoch_; }
+    UnitState& claim(int unit) {
+        UnitState& s = units_[unit];
+        if (s.epoch != epoch_) {
+            s.epoch = epoch_;
+            s.owner = kNoOwner;
+            s.level = 1;
+        }
+        return s;
+    }
+
+    void setOwner(UnitState& state, int unit, int owner);
+    void raiseLevel(UnitState& state, int unit);
+    bool repeatsRound();
+
+    void visit(int player, int unit);
+    bool offer(DecisionKind kind, int player, int unit, int price, int level);
+    void payRent(int player, int unit, int host, int fine);
+    void bankrupt(int player);
+    void endTurn(int player);
+    void advance();
+
+    const BoardLayout* board_ = nullptr;
+    int numPlayers_ = 0;
+    Arena arena_;
+    uint32_t epoch_ = 0;
+
+    // Per unit, in the arena.
+    UnitState* units_ = nullptr;
+
+    // Per player, in the arena.
+    int32_t* location_ = nullptr;
+    int32_t* money_ = nullptr;
+    uint8_t* status_ = nullptr;
+    int32_t* collectables_ = nullptr;
+    DecisionPolicy** policies_ = nullptr;
+
+    GameStats* stats_ = nullptr;
+    uint64_t unitHash_ = 0;   // owner and level keys of every unit
+
+    // Round-start hashes seen this game, open addressing; a slot from an
+    // older stallEpoch_ is empty.
+    struct StallSlot {
+        uint64_t hash;
+        uint32_t epoch;
+        uint32_t count;
+    };
+    std::vector<StallSlot> stallSlots_;
+    uint32_t stallEpoch_ = 0;
+    int stallUsed_ = 0;
+    int stallLimit_ = 0;
+    bool stalled_ = false;
+
+    Rng rng_;
+    int current_ = 0;
+    int activePlayers_ = 0;
+    long turns_ = 0;
+    bool over_ = false;
+};
+
+#endif
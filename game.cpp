@@ -0,0 +1,164 @@
+#include "game.h"
+
+
+// ================== Game ==================
+Game::Game(WorldMap& map, WorldPlayer& players, uint64_t seed, uint64_t stream)
+    : map_(map), players_(players),
+      policies_(players.getPlayerCount(), nullptr),
+      rng_(seed, stream),
+      activePlayers_(players.getPlayerCount()) {
+    ctx_.rng = &rng_;
+    placePlayersAtStart();
+}
+
+void Game::reset(uint64_t seed, uint64_t stream) {
+    map_.reset();
+    players_.reset();
+    rng_.seed(seed, stream);
+    currentPlayerIndex_ = 0;
+    activePlayers_ = players_.getPlayerCount();
+    lastDiceRoll_ = 0;
+    turns_ = 0;
+    over_ = false;
+    placePlayersAtStart();
+}
+
+// Place all players at the starting point (location 0).
+void Game::placePlayersAtStart() {
+    for (int i = 0; i < players_.getPlayerCount(); ++i) {
+        map_.getUnit(0)->addPlayerHere(players_.playerNow(i));
+    }
+}
+
+void Game::setPolicy(int playerIndex, DecisionPolicy* policy) {
+    if (playerIndex >= 0 && playerIndex < int(policies_.size())) {
+        policies_[playerIndex] = policy;
+    }
+}
+
+TurnOutcome Game::beginTurn() {
+    Player* currentPlayer = getCurrentPlayer();
+
+    // If the current player is bankrupt, skip their turn and move to the next player.
+    if (currentPlayer->getStatus() == PlayerStatus::Bankrupt) {
+        advance();
+        return TurnOutcome::SkippedBankrupt;
+    }
+
+    ++turns_;
+
+    // If the current player is in jail, they miss a turn.
+    if (currentPlayer->getStatus() == PlayerStatus::InJail) {
+        if (ctx_.out) *ctx_.out << currentPlayer->getName() << " is in jail and misses a turn.";
+        currentPlayer->releaseFromJail(); // Release them from jail for the next round.
+        if (journal_) journal_->recordTurn(0);
+        advance();
+        return TurnOutcome::SkippedJail;
+    }
+
+    lastDiceRoll_ = rollDice();
+    if (journal_) journal_->recordTurn(lastDiceRoll_);
+
+    int oldLocation = currentPlayer->getLocation();
+    int newLocation = (oldLocation + lastDiceRoll_) % map_.getUnitCount();
+
+    // Check if the player passed "GO" (crossed the starting point).
+    if (newLocation < oldLocation) {
+        int reward = 2000;
+        currentPlayer->receive(reward);
+    }
+    currentPlayer->moveTo(newLocation, &map_);
+    return TurnOutcome::Moved;
+}
+
+void Game::finishTurn() {
+    Player* currentPlayer = getCurrentPlayer();
+    MapUnit* currentUnit = map_.getUnit(currentPlayer->getLocation());
+
+    // Trigger the onVisit action for the unit the player landed on.
+    ctx_.policy = policies_[currentPlayerIndex_];
+    if (journal_) ctx_.policy = journal_->tap(ctx_.policy);
+    currentUnit->onVisit(currentPlayer, ctx_);
+
+    // Check for bankruptcy after actions.
+    if (currentPlayer->getMoney() < 0) {
+        if (ctx_.out) *ctx_.out << "\n" << currentPlayer->getName() << " is bankrupt!";
+        currentPlayer->declareBankruptcy();
+        activePlayers_--;
+    }
+
+    advance();
+
+    // If only one player remains active, the game ends.
+    if (activePlayers_ <= 1) {
+        over_ = true;
+    }
+}
+
+bool Game::pendingDecision(Decision& decision) const {
+    const Player* currentPlayer = getCurrentPlayer();
+    return map_.getUnit(currentPlayer->getLocation())->pendingDecision(currentPlayer, decision);
+}
+
+TurnOutcome Game::playTurn() {
+    TurnOutcome outcome = beginTurn();
+    if (outcome == TurnOutcome::Moved) {
+        finishTurn();
+    }
+    return outcome;
+}
+
+int Game::runToCompletion(long maxTurns) {
+    while (!over_ && turns_ < maxTurns) {
+        playTurn();
+    }
+    return getLeader();
+}
+
+bool Game::save(GameState& state) const {
+    state.reset(players_.getPlayerCount(), map_.getUnitCount());
+    if (!map_.save(state) || !players_.save(state)) return false;
+    state.currentPlayer = currentPlayerIndex_;
+    state.activePlayers = activePlayers_;
+    state.over = over_;
+    state.turns = turns_;
+    rng_.savePosition(state.rngKey, state.rngCounter, state.rngPosition);
+    return true;
+}
+
+bool Game::restore(const GameState& state) {
+    if (!isStateConsistent(state) || int(state.playerCount) != players_.getPlayerCount() ||
+        int(state.unitCount) != map_.getUnitCount() || state.boardFingerprint != map_.fingerprint()) {
+        return false;
+    }
+    players_.restore(state);
+    map_.restore(state, players_);
+    currentPlayerIndex_ = state.currentPlayer;
+    activePlayers_ = state.activePlayers;
+    over_ = state.over;
+    turns_ = state.turns;
+    lastDiceRoll_ = 0;
+    rng_.restorePosition(state.rngKey, state.rngCounter, state.rngPosition);
+    return true;
+}
+
+int Game::getLeader() const {
+    int leader = -1;
+    for (int i = 0; i < players_.getPlayerCount(); ++i) {
+        const Player* p = players_.playerNow(i);
+        if (p->getStatus() == PlayerStatus::Bankrupt) continue;
+        if (leader < 0 || p->getMoney() > players_.playerNow(leader)->getMoney()) {
+            leader = i;
+        }
+    }
+    return leader;
+}
+
+// Rolls a dice and returns a random number between 1 and 6.
+int Game::rollDice() {
+    return rng_.rollDie();
+}
+
+void Game::advance() {
+    currentPlayerIndex_ = (currentPlayerIndex_ + 1) % players_.getPlayerCount();
+}
@@ -0,0 +1,87 @@
+#ifndef GAME__
+#define GAME__
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "map.h"
+#include "player.h"
+#include "game_state.h"
+#include "journal.h"
+#include "policy.h"
+#include "rng.h"
+
+enum class TurnOutcome { SkippedBankrupt, SkippedJail, Moved };
+
+// ================== Game ==================
+// The turn engine. It owns no terminal: decisions go through one
+// DecisionPolicy per seat and narration goes to an optional stream, so the
+// same rules run behind the interactive CLI and headless simulations.
+class Game {
+public:
+    Game(WorldMap& map, WorldPlayer& players, uint64_t seed = 0, uint64_t stream = 0);
+
+    // Starts a fresh game on the same board and seats, reusing every
+    // allocation. The (seed, stream) pair alone determines every die of the
+    // new game, so any game of a tournament can be replayed on its own.
+    void reset(uint64_t seed, uint64_t stream = 0);
+
+    void setPolicy(int playerIndex, DecisionPolicy* policy);
+    void setOutput(std::ostream* out) { ctx_.out = out; }
+    // Records every turn from now on (null stops recording).
+    void setJournal(JournalWriter* journal) { journal_ = journal; }
+
+    // A turn is split in two so a frontend can redraw between the move and
+    // the visit. beginTurn() skips bankrupt/jailed seats (advancing to the
+    // next player) or rolls and moves the current player and returns Moved;
+    // only then must finishTurn() be called to resolve the visit.
+    TurnOutcome beginTurn();
+    void finishTurn();
+    // Between beginTurn() and finishTurn(): the question the visit is about
+    // to ask the mover, if any. A frontend that gets answers asynchronously
+    // can collect the answer first and then let finishTurn() run.
+    bool pendingDecision(Decision& decision) const;
+    TurnOutcome playTurn();
+
+    // Plays until one player is left or maxTurns turns were started.
+    // Returns the id of the richest active player.
+    int runToCompletion(long maxTurns);
+
+    bool isOver() const { return over_; }
+    int getCurrentPlayerIndex() const { return currentPlayerIndex_; }
+    Player* getCurrentPlayer() const { return players_.playerNow(currentPlayerIndex_); }
+    int getActivePlayers() const { return activePlayers_; }
+    long getTurnCount() const { return turns_; }
+    int getLastDiceRoll() const { return lastDiceRoll_; }
+    int getLeader() const;
+    Rng& getRng() { return rng_; }
+
+    // Snapshot of the whole game between turns: board, players, turn order
+    // and dice position. restore() fails (and changes nothing it has not
+    // validated) if the state belongs to another board or seat count.
+    bool save(GameState& state) const;
+    bool restore(const GameState& state);
+
+    WorldMap& getMap() const { return map_; }
+    WorldPlayer& getPlayers() const { return players_; }
+
+private:
+    int rollDice();
+    void advance();
+    void placePlayersAtStart();
+
+    WorldMap& map_;
+    WorldPlayer& players_;
+    std::vector<DecisionPolicy*> policies_;
+    VisitContext ctx_;
+    JournalWriter* journal_ = nullptr;
+    Rng rng_;
+    int currentPlayerIndex_ = 0;
+    int activePlayers_ = 0;
+    int lastDiceRoll_ = 0;
+    long turns_ = 0;
+    bool over_ = false;
+};
+
+#endif
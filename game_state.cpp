@@ -0,0 +1,74 @@
+#include "game_state.h"
+#include <fstream>
+
+
+// ================== Game State ==================
+void GameState::reset(int playerCount, int unitCount) {
+    static_cast<StateHeader&>(*this) = StateHeader();
+    magic = kMagic;
+    version = kVersion;
+    this->playerCount = playerCount;
+    this->unitCount = unitCount;
+    players.assign(playerCount, PlayerSnapshot{});
+    units.assign(unitCount, UnitSnapshot{});
+}
+
+bool isStateConsistent(const GameState& state) {
+    if (state.magic != GameState::kMagic || state.version != GameState::kVersion ||
+        state.playerCount > kMaxStatePlayers || state.unitCount > kMaxStateUnits ||
+        state.players.size() != state.playerCount || state.units.size() != state.unitCount ||
+        state.currentPlayer >= state.playerCount || state.activePlayers > state.playerCount) {
+        return false;
+    }
+    for (const UnitSnapshot& unit : state.units) {
+        if (unit.owner < -1 || unit.owner >= int64_t(state.playerCount) || unit.level < 1 || unit.level > 5) return false;
+    }
+    for (uint32_t p = 0; p < state.playerCount; ++p) {
+        const PlayerSnapshot& player = state.players[p];
+        // PlayerStatus: Normal, InJail, Bankrupt
+        if (player.location >= state.unitCount || player.status > 2) return false;
+    }
+    return true;
+}
+
+bool writeState(std::ostream& out, const GameState& state) {
+    const StateHeader& header = state;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(state.players.data()), state.players.size() * sizeof(PlayerSnapshot));
+    out.write(reinterpret_cast<const char*>(state.units.data()), state.units.size() * sizeof(UnitSnapshot));
+    return bool(out);
+}
+
+bool readState(std::istream& in, GameState& state) {
+    GameState loaded;
+    StateHeader& header = loaded;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != StateHeader::kMagic ||
+        header.version != StateHeader::kVersion || header.playerCount > kMaxStatePlayers ||
+        header.unitCount > kMaxStateUnits) {
+        return false;
+    }
+    loaded.players.resize(header.playerCount);
+    loaded.units.resize(header.unitCount);
+    if (!in.read(reinterpret_cast<char*>(loaded.players.data()), loaded.players.size() * sizeof(PlayerSnapshot)) ||
+        !in.read(reinterpret_cast<char*>(loaded.units.data()), loaded.units.size() * sizeof(UnitSnapshot)) ||
+        !isStateConsistent(loaded)) {
+        return false;
+    }
+    state = std::move(loaded);
+    return true;
+}
+
+bool writeStateFile(const std::string& path, const GameState& state) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    return writeState(out, state);
+}
+
+bool readStateFile(const std::string& path, GameState& state) {
+    std::ifstream in(path, std::ios::binary);
+    GameState loaded;
+    if (!readState(in, loaded) || in.peek() != EOF) {
+        return false;
+    }
+    state = std::move(loaded);
+    return true;
+}
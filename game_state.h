@@ -0,0 +1,86 @@
+#ifndef GAME_STATE__
+#define GAME_STATE__
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// ================== Game State ==================
+// A complete, self-contained picture of a game in progress: a plain header
+// plus one PlayerSnapshot per seat and one UnitSnapshot per unit, as many
+// as the game has. Saving into the same GameState again reuses its arrays,
+// so lookahead can refresh one thousands of times per second without
+// allocating. Both Game (over WorldMap/WorldPlayer) and FastGame save to
+// and restore from it.
+//
+// Written out (save games, journals) it is the header followed by the two
+// arrays, in host byte order. Counts above these limits are taken for a
+// corrupt file rather than allocated.
+const int kMaxStatePlayers = 1 << 16;
+const int kMaxStateUnits = 1 << 24;
+
+struct PlayerSnapshot {
+    int32_t money;
+    uint32_t location;
+    uint8_t status;      // PlayerStatus
+    uint8_t reserved[3];
+};
+
+struct UnitSnapshot {
+    int32_t owner;       // player id, or -1
+    int8_t level;        // 1..5 (always 1 for non-upgradable units)
+    uint8_t reserved[3];
+};
+
+struct StateHeader {
+    static constexpr uint32_t kMagic = 0x54534D4D; // "MMST"
+    static constexpr uint16_t kVersion = 2;
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t over = 0;
+    uint32_t unitCount = 0;
+    uint32_t boardFingerprint = 0; // catches restoring onto a different map
+    uint32_t playerCount = 0;
+    uint32_t currentPlayer = 0;
+    uint32_t activePlayers = 0;
+    uint32_t turns = 0;
+    uint32_t rngPosition = 0;      // dice already taken from the current batch
+    uint32_t reserved = 0;
+    uint64_t rngKey = 0;
+    uint64_t rngCounter = 0;       // counter where the current batch started
+};
+
+struct GameState : StateHeader {
+    std::vector<PlayerSnapshot> players;   // playerCount
+    std::vector<UnitSnapshot> units;       // unitCount
+
+    // Sets the header to a fresh kMagic/kVersion one and sizes the arrays.
+    void reset(int playerCount, int unitCount);
+};
+
+// Fingerprint of a board's shape (unit kinds and prices, in order), folded
+// one unit at a time starting from kFingerprintSeed.
+const uint32_t kFingerprintSeed = 2166136261u;
+inline uint32_t fingerprintUnit(uint32_t hash, int kind, int32_t price) {
+    hash = (hash ^ uint32_t(kind)) * 16777619u;
+    return (hash ^ uint32_t(price)) * 16777619u;
+}
+
+// Whether every index in the snapshot is in range for its own counts:
+// version, array sizes, current player, active players, unit owners and
+// levels, player locations and statuses. Engines check this before restoring, so a
+// corrupt or hand-edited save is refused instead of indexing past a table.
+bool isStateConsistent(const GameState& state);
+
+// The header and arrays to/from a stream; reading checks magic, version
+// and the count limits before sizing the arrays, and isStateConsistent().
+bool writeState(std::ostream& out, const GameState& state);
+bool readState(std::istream& in, GameState& state);
+
+// Save-game files hold just the state (writeState), nothing after it.
+bool writeStateFile(const std::string& path, const GameState& state);
+bool readStateFile(const std::string& path, GameState& state);
+
+#endif
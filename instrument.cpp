@@ -0,0 +1,200 @@
+#include "instrument.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+
+namespace instrument {
+
+std::atomic<bool> gEnabled{false};
+
+namespace {
+
+const int kTimers = static_cast<int>(Timer::Count);
+const int kCounters = static_cast<int>(Counter::Count);
+const int kBuckets = 64;   // bucket b holds durations in [2^(b-1), 2^b) ns
+
+const char* const kTimerNames[kTimers] = {
+    "turn", "input_wait", "render", "clear_screen", "dice", "move",
+    "visit_upgradable", "visit_collectable", "visit_random_cost", "visit_jail",
+};
+const char* const kCounterNames[kCounters] = {"pay", "receive", "bankruptcy"};
+
+// Only the owning thread writes, so a relaxed load + store is enough and
+// dump() can read concurrently without tearing.
+template <class T>
+inline void bump(std::atomic<T>& cell, T value) {
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct Histogram {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> buckets[kBuckets] = {};
+};
+
+struct Tally {
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> sum{0};
+};
+
+struct Table {
+    Histogram timers[kTimers];
+    Tally counters[kCounters];
+};
+
+// Tables are never freed, so a dump still sees threads that have exited.
+std::mutex gTablesLock;
+std::vector<Table*> gTables;
+
+Table& localTable() {
+    thread_local Table* table = nullptr;
+    if (!table) {
+        table = new Table;
+        std::lock_guard<std::mutex> lock(gTablesLock);
+        gTables.push_back(table);
+    }
+    return *table;
+}
+
+volatile std::sig_atomic_t gDumpRequested = 0;
+std::string gExitPath;
+
+void onSignal(int) {
+    gDumpRequested = 1;
+}
+
+void dumpToPath(const std::string& path) {
+    if (path.empty()) {
+        dump(std::cerr);
+        return;
+    }
+    std::ofstream out(path, std::ios::app);
+    dump(out);
+}
+
+void dumpOnExit() {
+    dumpToPath(gExitPath);
+}
+
+// Upper edge of the bucket holding the q-quantile, capped at the maximum.
+double quantileUs(const uint64_t* buckets, uint64_t count, uint64_t max, double q) {
+    uint64_t rank = uint64_t(q * count);
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen > rank) {
+            uint64_t edge = b >= 63 ? max : (uint64_t(1) << b);
+            return (edge < max ? edge : max) / 1000.0;
+        }
+    }
+    return max / 1000.0;
+}
+
+} // namespace
+
+void enable(bool on) {
+    gEnabled.store(on, std::memory_order_relaxed);
+}
+
+int64_t startTimer() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    return ns != 0 ? ns : 1;
+}
+
+void stopTimer(Timer timer, int64_t start) {
+    uint64_t nanoseconds = uint64_t(startTimer() - start);
+    Histogram& h = localTable().timers[static_cast<int>(timer)];
+    int bucket = nanoseconds == 0 ? 0 : 64 - __builtin_clzll(nanoseconds);
+    if (bucket >= kBuckets) bucket = kBuckets - 1;
+    bump<uint64_t>(h.count, 1);
+    bump<uint64_t>(h.total, nanoseconds);
+    bump<uint64_t>(h.buckets[bucket], 1);
+    if (nanoseconds > h.max.load(std::memory_order_relaxed)) {
+        h.max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void recordCount(Counter counter, int64_t value) {
+    Tally& t = localTable().counters[static_cast<int>(counter)];
+    bump<uint64_t>(t.count, 1);
+    bump<int64_t>(t.sum, value);
+}
+
+void dump(std::ostream& out) {
+    uint64_t count[kTimers] = {}, total[kTimers] = {}, max[kTimers] = {};
+    uint64_t buckets[kTimers][kBuckets] = {};
+    uint64_t hits[kCounters] = {};
+    int64_t sums[kCounters] = {};
+    {
+        std::lock_guard<std::mutex> lock(gTablesLock);
+        for (const Table* table : gTables) {
+            for (int t = 0; t < kTimers; ++t) {
+                const Histogram& h = table->timers[t];
+                count[t] += h.count.load(std::memory_order_relaxed);
+                total[t] += h.total.load(std::memory_order_relaxed);
+                uint64_t m = h.max.load(std::memory_order_relaxed);
+                if (m > max[t]) max[t] = m;
+                for (int b = 0; b < kBuckets; ++b) {
+                    buckets[t][b] += h.buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+            for (int c = 0; c < kCounters; ++c) {
+                hits[c] += table->counters[c].count.load(std::memory_order_relaxed);
+                sums[c] += table->counters[c].sum.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << std::left << std::setw(20) << "timer" << std::right << std::setw(10) << "count"
+        << std::setw(12) << "mean us" << std::setw(12) << "p50 us" << std::setw(12) << "p90 us"
+        << std::setw(12) << "p99 us" << std::setw(12) << "max us" << "\n";
+    for (int t = 0; t < kTimers; ++t) {
+        if (count[t] == 0) continue;
+        out << std::left << std::setw(20) << kTimerNames[t] << std::right << std::setw(10) << count[t]
+            << std::setw(12) << total[t] / 1000.0 / count[t]
+            << std::setw(12) << quantileUs(buckets[t], count[t], max[t], 0.50)
+            << std::setw(12) << quantileUs(buckets[t], count[t], max[t], 0.90)
+            << std::setw(12) << quantileUs(buckets[t], count[t], max[t], 0.99)
+            << std::setw(12) << max[t] / 1000.0 << "\n";
+    }
+    out << std::left << std::setw(20) << "counter" << std::right << std::setw(10) << "count"
+        << std::setw(12) << "sum" << "\n";
+    for (int c = 0; c < kCounters; ++c) {
+        if (hits[c] == 0) continue;
+        out << std::left << std::setw(20) << kCounterNames[c] << std::right << std::setw(10) << hits[c]
+            << std::setw(12) << sums[c] << "\n";
+    }
+    out.flags(flags);
+    out.flush();
+}
+
+void dumpAtExit(const std::string& path) {
+    static bool registered = false;
+    gExitPath = path;
+    if (!registered) {
+        registered = true;
+        std::atexit(dumpOnExit);
+    }
+}
+
+void installSignalHandler() {
+    std::signal(SIGUSR1, onSignal);
+}
+
+void pollSignal() {
+    if (gDumpRequested) {
+        gDumpRequested = 0;
+        dumpToPath(gExitPath);
+    }
+}
+
+} // namespace instrument
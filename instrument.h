@@ -0,0 +1,99 @@
+#ifndef INSTRUMENT__
+#define INSTRUMENT__
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// ================== Instrumentation ==================
+// Scoped timers and counters for the hot paths, built in only when the
+// program is compiled with -DMONOPOLY_INSTRUMENT; otherwise every
+// INSTRUMENT_* macro expands to nothing.
+//
+// When built in, probes still do nothing until instrument::enable() is
+// called: a disabled probe costs one relaxed load and a predictable branch.
+// An enabled timer records its duration in a log2 histogram, and counters
+// add up a count and a sum. Every thread writes only to its own tables
+// (single-writer atomics, no locks), which dump() merges.
+//
+//   void Rng::refill() {
+//       INSTRUMENT_SCOPE(Dice);
+//       ...
+//   INSTRUMENT_COUNT(Pay, amount);
+namespace instrument {
+
+enum class Timer : uint8_t {
+    Turn,           // engine + redraw of one CLI turn, per resume (a buy/upgrade prompt splits it)
+    InputWait,      // blocked reading stdin
+    Render,         // TerminalRenderer::present, on the render thread in the CLI (not game-thread time)
+    ClearScreen,
+    Dice,           // one batch of dice (Rng::refill), not each roll
+    Move,           // Player::moveTo
+    VisitUpgradable,
+    VisitCollectable,
+    VisitRandomCost,
+    VisitJail,
+    Count
+};
+
+enum class Counter : uint8_t {
+    Pay,            // sum is the amount charged
+    Receive,        // sum is the amount received
+    Bankruptcy,
+    Count
+};
+
+extern std::atomic<bool> gEnabled;
+
+inline bool isEnabled() { return gEnabled.load(std::memory_order_relaxed); }
+
+void enable(bool on = true);
+
+// Slow paths, only reached while enabled; kept out of line so a disabled
+// probe stays a load and a branch.
+[[gnu::cold, gnu::noinline]] int64_t startTimer();
+[[gnu::cold, gnu::noinline]] void stopTimer(Timer timer, int64_t start);
+[[gnu::cold, gnu::noinline]] void recordCount(Counter counter, int64_t value);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Timer timer) : timer_(timer), start_(isEnabled() ? startTimer() : 0) {}
+    ~ScopedTimer() {
+        if (start_ != 0) [[unlikely]] stopTimer(timer_, start_);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Timer timer_;
+    int64_t start_;   // steady clock in ns, 0 while disabled
+};
+
+// Prints every timer (count, mean, approximate p50/p90/p99 and max) and
+// counter with at least one hit, merged over all threads.
+void dump(std::ostream& out);
+
+// Dumps to `path` (stderr when empty) when the program exits normally.
+void dumpAtExit(const std::string& path = "");
+
+// SIGUSR1 asks for a dump; the handler only sets a flag, and the dump is
+// written by the next pollSignal() call from the program's own loop.
+void installSignalHandler();
+void pollSignal();
+
+} // namespace instrument
+
+#ifdef MONOPOLY_INSTRUMENT
+#define INSTRUMENT_CONCAT2(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT2(a, b)
+#define INSTRUMENT_SCOPE(timer) \
+    ::instrument::ScopedTimer INSTRUMENT_CONCAT(instrumentScope_, __LINE__)(::instrument::Timer::timer)
+#define INSTRUMENT_COUNT(counter, value) \
+    do { if (::instrument::isEnabled()) [[unlikely]] ::instrument::recordCount(::instrument::Counter::counter, (value)); } while (0)
+#else
+#define INSTRUMENT_SCOPE(timer) do {} while (0)
+#define INSTRUMENT_COUNT(counter, value) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+#include "journal.h"
+#include "game.h"
+#include <cstring>
+
+
+// ================== Journal Writer ==================
+bool JournalWriter::open(const std::string& path, const Game& game, uint64_t seed, uint64_t stream, bool restored) {
+    close();
+    JournalHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = JournalHeader::kMagic;
+    header.version = JournalHeader::kVersion;
+    // The names are read back per seat, a byte count of seats.
+    if (game.getPlayers().getPlayerCount() > 255) return false;
+    header.playerCount = game.getPlayers().getPlayerCount();
+    header.unitCount = game.getMap().getUnitCount();
+    header.boardFingerprint = game.getMap().fingerprint();
+    header.seed = seed;
+    header.stream = stream;
+
+    GameState state;
+    if (restored || game.getTurnCount() > 0) {
+        if (!game.save(state)) return false;
+        header.hasState = 1;
+    }
+
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) return false;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (header.hasState) {
+        writeState(out_, state);
+    }
+    for (int i = 0; i < header.playerCount; ++i) {
+        std::string name = game.getPlayers().playerNow(i)->getName().substr(0, 255);
+        out_.put(char(name.size()));
+        out_.write(name.data(), name.size());
+    }
+    buffer_.reserve(kBlockSize);
+    return bool(out_);
+}
+
+void JournalWriter::writeBlock() {
+    if (out_.is_open() && !buffer_.empty()) {
+        out_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size());
+    }
+    buffer_.clear();
+}
+
+void JournalWriter::flush() {
+    writeBlock();
+    if (out_.is_open()) out_.flush();
+}
+
+void JournalWriter::close() {
+    if (!out_.is_open()) return;
+    flush();
+    out_.close();
+}
+
+bool JournalWriter::decide(const Decision& decision) {
+    bool accept = inner_ && inner_->decide(decision);
+    if (!buffer_.empty()) {
+        buffer_.back() |= kJournalAsked | (accept ? kJournalAccepted : 0);
+    }
+    return accept;
+}
+
+// ================== Journal Reader ==================
+bool JournalReader::open(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (!in.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+        header_.magic != JournalHeader::kMagic) {
+        error = path + ": not a journal";
+        return false;
+    }
+    if (header_.version != JournalHeader::kVersion) {
+        error = path + ": journal version " + std::to_string(header_.version) + " is not supported";
+        return false;
+    }
+    if (header_.hasState && !readState(in, state_)) {
+        error = path + ": truncated or corrupt game state";
+        return false;
+    }
+    names_.assign(header_.playerCount, "");
+    for (std::string& name : names_) {
+        int length = in.get();
+        if (length == EOF) {
+            error = path + ": truncated player names";
+            return false;
+        }
+        name.resize(length);
+        in.read(name.data(), length);
+    }
+    turns_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// ================== Replay ==================
+bool replayJournal(const JournalReader& journal, Game& game, long stopTurn, std::string& error) {
+    const JournalHeader& header = journal.getHeader();
+    if (header.playerCount != game.getPlayers().getPlayerCount() ||
+        header.unitCount != uint32_t(game.getMap().getUnitCount()) ||
+        header.boardFingerprint != game.getMap().fingerprint()) {
+        error = "journal was recorded on another board or seat count";
+        return false;
+    }
+    game.reset(header.seed, header.stream);
+    if (journal.hasState() && !game.restore(journal.getState())) {
+        error = "journal start state does not match the board";
+        return false;
+    }
+
+    ScriptedPolicy answers;
+    for (int i = 0; i < header.playerCount; ++i) {
+        game.setPolicy(i, &answers);
+    }
+
+    const std::vector<uint8_t>& turns = journal.getTurns();
+    size_t next = 0;
+    while (next < turns.size() && !game.isOver() && (stopTurn < 0 || game.getTurnCount() < stopTurn)) {
+        TurnOutcome outcome = game.beginTurn();
+        if (outcome == TurnOutcome::SkippedBankrupt) continue;
+
+        uint8_t record = turns[next++];
+        int die = record & kJournalDieMask;
+        int rolled = outcome == TurnOutcome::Moved ? game.getLastDiceRoll() : 0;
+        if (die != rolled) {
+            error = "turn " + std::to_string(game.getTurnCount()) + ": journal has die " +
+                    std::to_string(die) + ", the game rolled " + std::to_string(rolled);
+            return false;
+        }
+        if (outcome != TurnOutcome::Moved) continue;
+
+        Decision decision;
+        bool asked = game.pendingDecision(decision);
+        if (asked != bool(record & kJournalAsked)) {
+            error = "turn " + std::to_string(game.getTurnCount()) + ": journal says the player was " +
+                    (asked ? "not asked" : "asked") + ", the game " + (asked ? "asks" : "does not ask");
+            return false;
+        }
+        answers.clear();
+        if (asked) answers.push(record & kJournalAccepted);
+        game.finishTurn();
+    }
+    return true;
+}
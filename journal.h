@@ -0,0 +1,117 @@
+#ifndef JOURNAL__
+#define JOURNAL__
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "game_state.h"
+#include "policy.h"
+
+class Game;
+
+// ================== Journal ==================
+// Append-only binary record of one game, enough to play it again exactly:
+//
+//   header   JournalHeader
+//   state    GameState (writeState)     only if hasState (a loaded game)
+//   names    playerCount x (uint8_t length, chars)
+//   turns    uint8_t per turn, until the end of the file
+//
+// A turn byte holds the die (1..6, or 0 for a turn spent in jail), whether
+// the mover was asked to buy or upgrade, and the answer. Bankrupt seats are
+// skipped without a turn and leave no byte. Integers are in host byte
+// order, like save games.
+struct JournalHeader {
+    static constexpr uint32_t kMagic = 0x4A4D4D4D; // "MMMJ"
+    static constexpr uint16_t kVersion = 2;    // 2: variable-length GameState
+
+    uint32_t magic;
+    uint16_t version;
+    uint8_t playerCount;
+    uint8_t hasState;
+    uint32_t unitCount;
+    uint32_t boardFingerprint;
+    uint64_t seed;
+    uint64_t stream;
+};
+
+const uint8_t kJournalDieMask = 0x07;
+const uint8_t kJournalAsked = 0x08;
+const uint8_t kJournalAccepted = 0x10;
+
+// Records a game as it is played: attach with Game::setJournal(). Turns are
+// buffered and appended to the file a block at a time, so recording costs
+// a byte store per turn; flush() writes out the partial block (an
+// interactive game does it every turn, a crash then loses nothing).
+class JournalWriter : public DecisionPolicy {
+public:
+    JournalWriter() = default;
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+    ~JournalWriter() { close(); }
+
+    // Truncates path and writes the header for `game` as it stands now,
+    // which was started from (seed, stream). A game restored from a save is
+    // stored as its snapshot, even one saved before the first roll: its dice
+    // come from the saved rng, not from seed.
+    bool open(const std::string& path, const Game& game, uint64_t seed, uint64_t stream = 0, bool restored = false);
+    void flush();
+    void close();
+    bool isOpen() const { return out_.is_open(); }
+
+    void recordTurn(int die) {
+        if (buffer_.size() >= kBlockSize) writeBlock();
+        buffer_.push_back(uint8_t(die));
+    }
+
+    // Stands between the engine and the mover's policy for one visit and
+    // notes the answer in the current turn's byte.
+    DecisionPolicy* tap(DecisionPolicy* policy) {
+        inner_ = policy;
+        return this;
+    }
+    bool decide(const Decision& decision) override;
+
+private:
+    static constexpr size_t kBlockSize = 4096;
+
+    void writeBlock();
+
+    std::ofstream out_;
+    std::vector<uint8_t> buffer_;
+    DecisionPolicy* inner_ = nullptr;
+};
+
+// A whole journal read into memory (a turn is one byte, so even very long
+// games are small).
+class JournalReader {
+public:
+    // On failure error says why.
+    bool open(const std::string& path, std::string& error);
+
+    const JournalHeader& getHeader() const { return header_; }
+    bool hasState() const { return header_.hasState != 0; }
+    const GameState& getState() const { return state_; }
+    std::vector<std::string>& getNames() { return names_; }
+    const std::vector<uint8_t>& getTurns() const { return turns_; }
+
+private:
+    JournalHeader header_{};
+    GameState state_;
+    std::vector<std::string> names_;
+    std::vector<uint8_t> turns_;
+};
+
+// Sets `game` up from the journal's header and re-executes its turns
+// without output until the journal ends, the game ends, or stopTurn turns
+// have been played (stopTurn < 0: no limit). Decisions come from the
+// journal; dice come from the game's own generator and are checked against
+// the recorded ones, as is every question asked, so the first turn where
+// the engine no longer does what was recorded is reported in error.
+// `game` must be built on the journal's board and seat count; its
+// policies are replaced.
+bool replayJournal(const JournalReader& journal, Game& game, long stopTurn, std::string& error);
+
+#endif
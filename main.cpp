@@ -1,168 +1,411 @@
 #include <iostream>
+#include <algorithm>
 #include <vector>
 #include <string>
-#include <iomanip>    // For std::setw and std::left
 #include <limits>     // For std::numeric_limits
-#include <cstdlib>    // For rand() and srand()
+#include <cstdlib>    // For strtoull(), atoi()
 #include <ctime>      // For time()
+#include <cstdint>
+#include <sstream>
 
 #include "map.h"
 #include "player.h"
+#include "game.h"
+#include "game_state.h"
+#include "instrument.h"
+#include "journal.h"
+#include "map_image.h"
+#include "policy.h"
+#include "renderer.h"
+#include "session.h"
+#ifdef MONOPOLY_EMBEDDED_BOARD
+#include "embedded_board.h"
+#include "static_game.h"
+#endif
 
 
 void clearScreen();
-void displayBoard(const WorldMap& map, const WorldPlayer& players);
-void displayPlayerStatus(const WorldPlayer& players, int currentPlayerIndex);
-int rollDice();
 void waitForEnter();
 
-int main() {
-    srand(time(0));
+// Seats beyond the first 64 would still play, but lose the fast
+// per-seat occupancy bits.
+const int kMaxPlayers = 64;
+// Larger games skip the name prompts and use the default names.
+const int kMaxNamedPlayers = 8;
+// Once no human is left in the game the bots play at most this many more
+// turns, as in a tournament, since nothing else would stop a stalled game.
+const long kBotOnlyTurns = 10000;
+
+// ================== Turn Digest ==================
+// What happened while nobody was asked anything: the turns bots played and
+// the jail skips, per seat, against a snapshot of every player taken when
+// the last human turn ended. Bounded by the seat count however many turns
+// went by.
+class TurnDigest {
+public:
+    explicit TurnDigest(const WorldPlayer& players) : players_(players), seats_(players.getPlayerCount()) {
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < int(seats_.size()); ++i) {
+            Player* player = players_.playerNow(i);
+            seats_[i] = Seat{0, 0, player->getMoney(), player->getUnitCount(), player->getStatus() == PlayerStatus::Bankrupt};
+        }
+        turns_ = 0;
+    }
+    void played(int seat) { seats_[seat].turns++; turns_++; }
+    void jailed(int seat) { seats_[seat].jailed++; turns_++; }
+    long getTurns() const { return turns_; }
+
+    // One line per seat that played or changed, e.g.
+    //   King-Baby: 2 turns, 1 in jail, $30000 -> $28500, 3 units (+1)
+    void write(std::ostream& out) const {
+        if (turns_ == 0) return;
+        out << "While you waited (" << turns_ << (turns_ == 1 ? " turn" : " turns") << "):\n";
+        for (int i = 0; i < int(seats_.size()); ++i) {
+            const Seat& seat = seats_[i];
+            Player* player = players_.playerNow(i);
+            if (seat.bankrupt) continue;
+            if (player->getStatus() == PlayerStatus::Bankrupt) {
+                out << "  " << player->getName() << " is bankrupt!\n";
+                continue;
+            }
+            int units = player->getUnitCount();
+            if (seat.turns == 0 && seat.jailed == 0 && player->getMoney() == seat.money && units == seat.units) continue;
+            out << "  " << player->getName() << ": ";
+            if (seat.turns) out << seat.turns << (seat.turns == 1 ? " turn, " : " turns, ");
+            if (seat.jailed) out << seat.jailed << " in jail, ";
+            out << "$" << seat.money << " -> $" << player->getMoney() << ", " << units << " units";
+            if (units != seat.units) out << " (" << (units > seat.units ? "+" : "") << units - seat.units << ")";
+            out << "\n";
+        }
+    }
+
+private:
+    struct Seat {
+        long turns;
+        long jailed;
+        int money;
+        int units;
+        bool bankrupt;
+    };
+
+    const WorldPlayer& players_;
+    std::vector<Seat> seats_;
+    long turns_ = 0;
+};
+
+int main(int argc, char** argv) {
+    // A fixed seed replays the exact same dice: monopoly --seed 1234
+    // A saved game picks up where it was left: monopoly --load savegame.dat
+    // Timing histograms go to a file at exit or on SIGUSR1: monopoly --profile prof.txt
+    // Every game is journaled for `replay`: monopoly --journal game.journal
+    // Another board, as map.dat text or a mapc image: monopoly --map big.map
+    // The last seats played by bots, fast-forwarded between human turns: monopoly --bots 3
+    // (built with -DMONOPOLY_EMBEDDED_BOARD, the compiled-in board is the
+    // default and nothing is read from disk without --map)
+    uint64_t seed = time(0);
+#ifdef MONOPOLY_EMBEDDED_BOARD
+    std::string mapPath;
+#else
+    std::string mapPath = "map.dat";
+#endif
+    std::string loadPath;
+    std::string profilePath;
+    std::string journalPath = "game.journal";
+    int numBots = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--seed") {
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (arg == "--load") {
+            loadPath = argv[i + 1];
+        }
+        else if (arg == "--profile") {
+            profilePath = argv[i + 1];
+        }
+        else if (arg == "--journal") {
+            journalPath = argv[i + 1];
+        }
+        else if (arg == "--map") {
+            mapPath = argv[i + 1];
+        }
+        else if (arg == "--bots") {
+            numBots = std::atoi(argv[i + 1]);
+        }
+    }
+    if (!profilePath.empty()) {
+#ifndef MONOPOLY_INSTRUMENT
+        std::cerr << "--profile: built without -DMONOPOLY_INSTRUMENT, only the empty tables will be written\n";
+#endif
+        instrument::enable();
+        instrument::dumpAtExit(profilePath);
+        instrument::installSignalHandler();
+    }
 
     // 1. Game Setup
     int numPlayers = 0;
     // Default names for players, used if the user doesn't input custom names.
     std::vector<std::string> defaultNames = {"A-Tu", "Little-Mei", "King-Baby", "Mrs.Money"};
+    while (defaultNames.size() < kMaxPlayers) {
+        defaultNames.push_back("Player-" + std::to_string(defaultNames.size() + 1));
+    }
 
     clearScreen();
 
-    // ==================== Handle text or numeric input logic ====================
-    std::cout << "How many players?(Maximum:4)...>";
-    std::cin >> numPlayers;
-
-    // Scenario 1: Invalid input (e.g., text)
-    if (std::cin.fail()) {
-        numPlayers = 1; // Default to 1 player if input is invalid.
-        std::cin.clear(); // Clear the error flags on std::cin.
-        // Ignore the rest of the invalid input in the buffer up to the newline character.
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    GameState saved;
+    bool resume = false;
+    bool askNames = false;
+    if (!loadPath.empty()) {
+        resume = readStateFile(loadPath, saved) && saved.playerCount <= defaultNames.size();
+        if (!resume) {
+            std::cerr << "Cannot load " << loadPath << "\n";
+            return 1;
+        }
+        numPlayers = saved.playerCount;
     }
-    // Scenario 2: Input is a valid number
     else {
-        // Limit the number of players between 1 and 4.
-        if (numPlayers > 4) {
-            numPlayers = 4;
-        }
-        else if (numPlayers < 1) {
-            numPlayers = 1;
+        // ==================== Handle text or numeric input logic ====================
+        std::cout << "How many players?(Maximum:" << kMaxPlayers << ")...>";
+        std::cin >> numPlayers;
+
+        // Scenario 1: Invalid input (e.g., text)
+        if (std::cin.fail()) {
+            numPlayers = 1; // Default to 1 player if input is invalid.
+            std::cin.clear(); // Clear the error flags on std::cin.
+            // Ignore the rest of the invalid input in the buffer up to the newline character.
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         }
+        // Scenario 2: Input is a valid number
+        else {
+            // Limit the number of players between 1 and kMaxPlayers.
+            if (numPlayers > kMaxPlayers) {
+                numPlayers = kMaxPlayers;
+            }
+            else if (numPlayers < 1) {
+                numPlayers = 1;
+            }
 
-        // Clear the input buffer of any leftover newline characters before using getline.
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            // Clear the input buffer of any leftover newline characters before using getline.
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            askNames = true;
+        }
+    }
+    numBots = std::max(0, std::min(numBots, numPlayers));
 
-        // Loop to ask for player names based on the number of players.
-        for (int i = 0; i < numPlayers; ++i) {
-            std::string name;
-            std::cout << "Please input player " << i + 1 << "'s name (Default: " << defaultNames[i] << ")...>";
-            std::getline(std::cin, name);
+    // Loop to ask for player names based on the number of players; bots
+    // keep their default names.
+    for (int i = 0; askNames && i < numPlayers - numBots && numPlayers <= kMaxNamedPlayers; ++i) {
+        std::string name;
+        std::cout << "Please input player " << i + 1 << "'s name (Default: " << defaultNames[i] << ")...>";
+        std::getline(std::cin, name);
 
-            if (!name.empty()) {
-                defaultNames[i] = name;
-            }
+        if (!name.empty()) {
+            defaultNames[i] = name;
         }
     }
 
-    // Create an instance of the WorldMap, which loads map data from "map.dat".
-    WorldMap worldMap(numPlayers);
+    // Load the board: a compiled image, else map.dat text.
+    MapImage image;
+    std::string imageError;
+    std::vector<UnitSpec> specs;
+#ifdef MONOPOLY_EMBEDDED_BOARD
+    if (mapPath.empty()) {
+        specs = staticBoardSpecs<EmbeddedBoard>();
+    } else
+#endif
+    if (image.open(mapPath, imageError)) {
+        specs = image.toSpecs();
+    } else {
+        std::vector<std::string> errors;
+        parseMapFile(mapPath, specs, errors);
+        for (const auto& error : errors) std::cerr << error << "\n";
+    }
+    if (specs.empty()) {
+        std::cerr << mapPath << ": no units\n";
+        return 1;
+    }
+    WorldMap worldMap(numPlayers, specs);
 
     // Create WorldPlayer for manage all players
     WorldPlayer players(numPlayers, defaultNames);
-    // Place all players at the starting point (location 0).
-    for (int i = 0; i < numPlayers; ++i) {
-        worldMap.getUnit(0)->addPlayerHere(players.playerNow(i));
-    }
 
-    clearScreen();
-
-    // --- Initial Game State Display ---
-    displayBoard(worldMap, players);
-    displayPlayerStatus(players, 0);
-
-    // 2. Main Game Loop
-    int currentPlayerIndex = 0;
-    int activePlayers = numPlayers;
-
-    // The game loop continues until a specific condition (e.g., only one active player or exit choice) is met.
-    while (true) {
-        Player* currentPlayer = players.playerNow(currentPlayerIndex);
-
-        // If the current player is bankrupt, skip their turn and move to the next player.
-        if (currentPlayer->getStatus() == PlayerStatus::Bankrupt) {
-            currentPlayerIndex = (currentPlayerIndex + 1) % numPlayers;
-            clearScreen();
-            displayBoard(worldMap, players);
-            displayPlayerStatus(players, currentPlayerIndex);
-            continue;
-        }
-
-        // Prompt the current player for their action.
-        std::cout << currentPlayer->getName() << ", your action? (1:Dice [default] / 2:Exit)...>";
-        std::string choice = "";
-        std::getline(std::cin, choice);
-
-        // If the player chooses to exit, break the game loop.
-        if (choice == "2") {
+    // The engine places everyone at the starting point. Human seats make the
+    // session wait on each roll and each buy or upgrade question and this
+    // loop supplies the answer; bot seats (the last --bots ones) answer
+    // inside the session and never stop it.
+    Game game(worldMap, players, seed);
+    // Narration is held back until the frame it belongs under is drawn.
+    std::ostringstream narration;
+    game.setOutput(&narration);
+    if (resume && !game.restore(saved)) {
+        std::cerr << loadPath << " does not match this map\n";
+        return 1;
+    }
+    JournalWriter journal;
+    if (!journal.open(journalPath, game, seed, 0, resume)) {
+        std::cerr << "Cannot write the journal to " << journalPath << "\n";
+    }
+    game.setJournal(&journal);
+    ConsolePolicy console(worldMap, players);
+    TurnScheduler scheduler;
+    GameSession session(game, scheduler);
+    ThresholdPolicy bot;
+    for (int i = numPlayers - numBots; i < numPlayers; ++i) {
+        session.setBot(i, &bot);
+    }
+    auto isBot = [&](int seat) { return seat >= numPlayers - numBots; };
+
+    // The board is drawn on its own thread, only the cells that change.
+    // Before this thread writes to the terminal itself it waits for the
+    // frame and then prints the narration under it.
+    RenderThread display(std::cout);
+    auto showNarration = [&]() {
+        display.sync();
+        std::cout << narration.str();
+        narration.str("");
+    };
+
+    // After a turn the board is redrawn for the next player, once the
+    // narration has been read (bankrupt players are skipped silently).
+    //
+    // With bots at the table the game fast-forwards: bot turns and jail
+    // skips are not narrated, drawn or paused on. They run back to back
+    // until a human is asked something, who then gets one frame and the
+    // digest of what happened since their own turn.
+    bool fastForward = numBots > 0;
+    TurnDigest digest(players);
+    bool pause = false;
+    bool redraw = false;
+    auto narrateNext = [&]() {
+        game.setOutput(isBot(game.getCurrentPlayerIndex()) ? nullptr : &narration);
+    };
+    session.setEventSink([&](const TurnEvent& event) {
+        switch (event.kind) {
+        case TurnEvent::Kind::Rolled:
+            // Display the game board after the player has moved, before the
+            // visit. Narration nobody stopped to read is dropped with its frames.
+            if (fastForward && isBot(event.player)) break;
+            narration.str("");
+            display.publish(worldMap, players, game.getCurrentPlayerIndex());
+            break;
+        case TurnEvent::Kind::Moved:
+            redraw = true;
+            if (fastForward && isBot(event.player)) {
+                digest.played(event.player);
+            } else {
+                // The human reads their own turn; the digest starts after it.
+                pause = true;
+                digest.reset();
+            }
+            if (fastForward) narrateNext();
+            break;
+        case TurnEvent::Kind::Skipped:
+            redraw = true;
+            if (fastForward) {
+                if (event.outcome == TurnOutcome::SkippedJail) {
+                    digest.jailed(event.player);
+                    if (!isBot(event.player)) narration.str("");
+                }
+                narrateNext();
+            } else {
+                pause = event.outcome != TurnOutcome::SkippedBankrupt;
+            }
+            break;
+        default:
             break;
         }
-
-        // If the current player is in jail, they miss a turn.
-        if (currentPlayer->getStatus() == PlayerStatus::InJail) {
-            std::cout << currentPlayer->getName() << " is in jail and misses a turn.";
-            currentPlayer->releaseFromJail(); // Release them from jail for the next round.
-            waitForEnter();
-            currentPlayerIndex = (currentPlayerIndex + 1) % numPlayers;
-            clearScreen();
-            displayBoard(worldMap, players);
-            displayPlayerStatus(players, currentPlayerIndex);
-            continue; // Skip the rest of the current player's turn.
+    });
+    if (fastForward) narrateNext();
+    bool botsOnly = false;
+    auto capBotsOnly = [&]() {
+        for (int i = 0; i < numPlayers - numBots; ++i) {
+            if (players.playerNow(i)->getStatus() != PlayerStatus::Bankrupt) return;
         }
+        if (!botsOnly) session.setTurnLimit(game.getTurnCount() + kBotOnlyTurns);
+        botsOnly = true;
+    };
+    capBotsOnly();
 
-        // 4. Roll Dice and Move
-        int diceRoll = rollDice();
-
-        int oldLocation = currentPlayer->getLocation();
-        int newLocation = (oldLocation + diceRoll) % worldMap.getUnitCount();
+    // --- Initial Game State Display ---
+    display.publish(worldMap, players, game.getCurrentPlayerIndex());
+    session.start();
+    scheduler.runReady();
 
-        // Check if the player passed "GO" (crossed the starting point).
-        if (newLocation < oldLocation) {
-            int reward = 2000; // Initialize reward to 2000.
-            currentPlayer->receive(reward);
+    // 2. Main Game Loop
+    // The game runs until only one active player is left or someone chooses to exit.
+    while (!session.isFinished()) {
+        instrument::pollSignal();
+
+        if (session.waitingFor() == SessionWait::Answer) {
+            // Buy or upgrade question for the player who just moved.
+            showNarration();
+            session.deliverAnswer(console.decide(session.getPendingDecision()));
         }
-        // Move the player to the new location on the map.
-        currentPlayer->moveTo(newLocation, &worldMap);
-
-        // Get the MapUnit object at the player's new location.
-        MapUnit* currentUnit = worldMap.getUnit(newLocation);
-
-        // First, display the game board after the player has moved.
-        clearScreen();
-        displayBoard(worldMap, players);
-        displayPlayerStatus(players, currentPlayerIndex);
-
-        // Trigger the onVisit action for the unit the player landed on.
-        currentUnit->onVisit(currentPlayer);
+        else {
+            // Everything up to this turn is on disk before waiting on the player.
+            journal.flush();
+            if (pause) {
+                showNarration();
+                waitForEnter();
+                pause = false;
+            }
+            // Prompt the current player for their action; a bankrupt human
+            // is passed over, and while fast-forwarding that draws nothing.
+            Player* currentPlayer = game.getCurrentPlayer();
+            bool prompt = currentPlayer->getStatus() != PlayerStatus::Bankrupt;
+            if (!prompt && fastForward) capBotsOnly();
+            if (redraw && (prompt || !fastForward)) {
+                // Display board for the next turn.
+                display.publish(worldMap, players, game.getCurrentPlayerIndex());
+                redraw = false;
+            }
 
-        // Check for bankruptcy after actions.
-        if (currentPlayer->getMoney() < 0) {
-            std::cout << std::endl << currentPlayer->getName() << " is bankrupt!";
-            currentPlayer->declareBankruptcy();
-            activePlayers--;
+            if (prompt) {
+                digest.write(narration);
+                digest.reset();
+                showNarration();
+                std::cout << currentPlayer->getName() << ", your action? (1:Dice [default] / 2:Exit / 3:Save)...>";
+                std::string choice = "";
+                {
+                    INSTRUMENT_SCOPE(InputWait);
+                    std::getline(std::cin, choice);
+                }
+
+                // If the player chooses to exit, leave the game loop.
+                if (choice == "2") {
+                    break;
+                }
+                // Save the game between turns and ask again.
+                if (choice == "3") {
+                    GameState state;
+                    if (game.save(state) && writeStateFile("savegame.dat", state)) {
+                        std::cout << "Game saved to savegame.dat (resume with --load savegame.dat)\n";
+                    } else {
+                        std::cout << "Could not save the game\n";
+                    }
+                    continue;
+                }
+            }
+            session.deliverRoll();
         }
 
-        waitForEnter();
-
-        // Move to the next player in the turn order.
-        currentPlayerIndex = (currentPlayerIndex + 1) % numPlayers;
-
-        // If only one player remains active, the game ends.
-        if (activePlayers == 1) {
-            break;
-        }
+        // Run the turn up to the next question or roll.
+        INSTRUMENT_SCOPE(Turn);
+        scheduler.runReady();
+    }
 
-        // Display board for the next turn, clearing the screen first.
-        clearScreen();
-        displayBoard(worldMap, players);
-        displayPlayerStatus(players, currentPlayerIndex);
+    // The last turn's narration stays up until Enter. Turns fast-forwarded
+    // to the end of the game get their frame and digest.
+    if (digest.getTurns() > 0) {
+        display.publish(worldMap, players, game.getCurrentPlayerIndex());
+        digest.write(narration);
+    }
+    showNarration();
+    if (session.isFinished() && pause) {
+        waitForEnter();
     }
 
     std::cout << "The winner is determined!" << std::endl;
@@ -172,66 +415,16 @@ int main() {
 
 /* Clear the console screen */
 void clearScreen() {
-#ifdef _WIN32
-    system("cls");     // Windows
-#else
-    system("clear");   // Linux/macOS
-#endif
-}
-
-// Rolls a dice and returns a random number between 1 and 6.
-int rollDice() {
-    return rand() % 6 + 1;
+    INSTRUMENT_SCOPE(ClearScreen);
+    // ANSI "cursor home + erase display"; no shell is spawned.
+    std::cout << "\x1b[H\x1b[2J" << std::flush;
 }
 
 // Pauses execution until the user presses the Enter key.
 void waitForEnter() {
     std::cout << "\nPress Enter to continue...";
     std::string dummy = "";
+    INSTRUMENT_SCOPE(InputWait);
     std::getline(std::cin, dummy);
 }
 
-
-// Displays the game board, showing units, owners, prices/fines, and player positions.
-void displayBoard(const WorldMap& map, const WorldPlayer& players) {
-    if (map.getUnitCount() == 0) return; // If there are no units on the map, do nothing.
-
-    const int n_players = players.getPlayerCount(); // Get the total number of players.
-    // Calculate half the size of the board for symmetrical display.
-    int half_size = (map.getUnitCount() + 1) / 2;
-
-    int map_size = map.getUnitCount();
-    if (map.getUnitCount() % 2 == 1) {
-        std::cout << std::setw(40) << std::left << map.getUnit(0)->display() << std::endl;
-    }
-    else {
-        std::cout << std::setw(40) << std::left << map.getUnit(0)->display();
-        std::cout << std::setw(40) << std::left << map.getUnit(map_size-1)->display();
-        std::cout <<  std::endl;
-    }
-    // Loop through half of the units to display both left and right sides of the board.
-    for (int i = 1; i < half_size; ++i) {
-        std::cout << std::setw(40) << std::left << map.getUnit(i)->display();
-        std::cout << std::setw(40) << std::left << map.getUnit(map_size-1-i)->display();
-        std::cout << std::endl;
-    }
-}
-
-// Displays the status of all active players.
-void displayPlayerStatus(const WorldPlayer& players, int currentPlayerIndex) {
-    std::cout << std::endl;
-    for (int i = 0; i < players.getPlayerCount(); ++i) {
-        const auto* p = players.playerNow(i);
-        if (p->getStatus() == PlayerStatus::Bankrupt) {
-            continue;
-        }
-
-        if (i == currentPlayerIndex) std::cout << "=>";
-        else std::cout << "  ";
-
-        std::cout << "[" << p->getId() << "]  " << std::setw(15) << std::right << p->getName().substr(0, 15)
-                  << "  $" << std::setw(7) << std::left << p->getMoney()
-                  << "with " << p->getUnitCount() << " units" << std::endl;
-    }
-    std::cout << std::endl;
-}
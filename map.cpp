@@ -1,42 +1,63 @@
 #include "map.h"
 #include "player.h" // Needed for onVisit implementations
+#include "policy.h"
+#include "rng.h"
+#include "game_state.h"
+#include "instrument.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
-#include <cstdlib>
 #include <string>
 #include <iomanip>
 
 // ===== MapUnit (base class) =====
-MapUnit::MapUnit(int id, const std::string& name, int numPlayers)
-: id_(id), name_(name), playersHerePtrs_(numPlayers, nullptr) {}
+MapUnit::MapUnit(int id, UnitKind kind, const std::string& name, int numPlayers)
+: id_(id), kind_(kind), seatColumns_(numPlayers <= kMaxSeatColumns ? numPlayers : 0), name_(name) {}
 
+const std::string& MapUnit::type() const {
+  static const std::string tags[kNumUnitKinds] = {"U", "C", "R", "J"};
+  return tags[static_cast<int>(kind_)];
+}
+
+// Adding a seat that is already here (or removing one that is not) is a
+// no-op for the first 64 seats; beyond that the callers keep every player
+// on exactly one unit, as Player::moveTo does.
 void MapUnit::addPlayerHere(Player* p) {
   int id = p->getId();
-  if (id >= 0 && id < playersHerePtrs_.size()) {
-    playersHerePtrs_[id] = p;
+  if (id >= 0 && id < 64) {
+    uint64_t bit = uint64_t(1) << id;
+    if (seatsHere_ & bit) return;
+    seatsHere_ |= bit;
   }
+  ++playersHere_;
 }
 
 void MapUnit::removePlayerHere(Player* p) {
   int id = p->getId();
-  if (id >= 0 && id < playersHerePtrs_.size()) {
-    playersHerePtrs_[id] = nullptr;
+  if (id >= 0 && id < 64) {
+    uint64_t bit = uint64_t(1) << id;
+    if (!(seatsHere_ & bit)) return;
+    seatsHere_ &= ~bit;
   }
+  if (playersHere_ > 0) --playersHere_;
 }
 
-const std::vector<Player*>& MapUnit::getPlayersHere() const {
-  return playersHerePtrs_;
+void MapUnit::clearPlayersHere() {
+  playersHere_ = 0;
+  seatsHere_ = 0;
 }
 
 std::string MapUnit::getPlayersHereString() const {
   std::string s = "=";
-  for (Player* ptr : playersHerePtrs_) {
-      if (ptr) {
-          s += std::to_string(ptr->getId());
-      } else {
-          s += " ";
-      }
+  if (seatColumns_ > 0) {
+    for (int id = 0; id < seatColumns_; ++id) {
+      s += isSeatHere(id) ? char('0' + id) : ' ';
+    }
+  } else {
+    // Room for up to 999 players on one unit.
+    std::string count = playersHere_ > 0 ? std::to_string(playersHere_) : "";
+    if (count.size() < 3) s.append(3 - count.size(), ' ');
+    s += count;
   }
   s += "=";
   return s;
@@ -55,25 +76,33 @@ const std::string MapUnit::display() const {
 
 
 // ================== Purchasable Unit ====================
-PurchasableUnit::PurchasableUnit(int id, const std::string& name, int numPlayers, int price)
-        : MapUnit(id, name, numPlayers), price_(price), host_(nullptr) {}
-
-
-void PurchasableUnit::tryToBuy(Player* player) {
-  int price = getPrice();
-  if (player->getMoney() >= price) {
-    std::cout << player->getName() << ", do you want to buy " << getName() << "? (1: Yes [default] / 2: No) ...>";
-    std::string buy_choice = "";
-    std::getline(std::cin, buy_choice);
-    if (buy_choice != "2") {
-        player->pay(price);
-        player->addUnit(this);
-        setHost(player);
-        std::cout << "You pay $" << price << " to buy " << getName();
-    }
+PurchasableUnit::PurchasableUnit(int id, UnitKind kind, const std::string& name, int numPlayers, int price)
+        : MapUnit(id, kind, name, numPlayers), price_(price), host_(nullptr) {}
+
+
+void PurchasableUnit::tryToBuy(Player* player, VisitContext& ctx) {
+  Decision decision;
+  if (PurchasableUnit::pendingDecision(player, decision) && ctx.policy->decide(decision)) {
+    int price = decision.price;
+    player->pay(price);
+    player->addUnit(this);
+    setHost(player);
+    if (ctx.out) *ctx.out << "You pay $" << price << " to buy " << getName();
   }
 }
 
+// An unowned unit is offered to anyone who can afford it.
+bool PurchasableUnit::pendingDecision(const Player* player, Decision& decision) const {
+  if (host_ || player->getMoney() < price_) return false;
+  decision = Decision();
+  decision.kind = DecisionKind::Buy;
+  decision.playerId = player->getId();
+  decision.unitId = getId();
+  decision.money = player->getMoney();
+  decision.price = price_;
+  return true;
+}
+
 const std::string PurchasableUnit::display() const {
   std::ostringstream oss;
   oss << MapUnit::display();
@@ -90,45 +119,54 @@ const std::string PurchasableUnit::display() const {
 
 // ================== Upgradable Unit ====================
 UpgradableUnit::UpgradableUnit(int id, const std::string& name, int numPlayers, int price, int upgrade_price, const int* fines)
-  : PurchasableUnit(id, name, numPlayers, price), upgrade_price_(upgrade_price), level_(1) {
+  : PurchasableUnit(id, UnitKind::Upgradable, name, numPlayers, price), upgrade_price_(upgrade_price), level_(1) {
   for (int i = 0; i < 5; ++i) {
     fines_[i] = fines[i];
   }
 }
 
-void UpgradableUnit::onVisit(Player* player) {
+void UpgradableUnit::onVisit(Player* player, VisitContext& ctx) {
+  INSTRUMENT_SCOPE(VisitUpgradable);
   if (!host_) {
-    tryToBuy(player);
+    tryToBuy(player, ctx);
   }
   else if (host_ != player) {
     // If the unit is owned by another player, the visiting player must pay a fine
     int fine = getFine();
-    std::cout << player->getName() << ", you must pay $" << fine << " to Player " << host_->getId() << " (" << host_->getName() << ")";
+    if (ctx.out) *ctx.out << player->getName() << ", you must pay $" << fine << " to Player " << host_->getId() << " (" << host_->getName() << ")";
     int payment = player->pay(fine);
     host_->receive(payment);
   }
   else if (host_ == player) {
     // upgrade if the owner is the same as the visiting player
     if (getLevel() < 5) {
-      int upgrade_price = getUpgradePrice();
-      if (player->getMoney() >= upgrade_price) {
-           std::cout << player->getName() << ", do you want to upgrade " << getName() << "? (1: Yes [default] / 2: No)...>";
-           std::string upgrade_choice = "";
-           std::getline(std::cin, upgrade_choice);
-           if(upgrade_choice != "2") {
-              player->pay(upgrade_price);
-              upgrade();
-              std::cout << "You pay $" << upgrade_price << " to upgrade " << getName() << " to Lv." << getLevel();
-           }
+      Decision decision;
+      if (pendingDecision(player, decision) && ctx.policy->decide(decision)) {
+        int upgrade_price = decision.price;
+        player->pay(upgrade_price);
+        upgrade();
+        if (ctx.out) *ctx.out << "You pay $" << upgrade_price << " to upgrade " << getName() << " to Lv." << getLevel();
       }
     }
     else {
-      std::cout << player->getName() << ", your " << getName() << " already reaches the highest level!";
+      if (ctx.out) *ctx.out << player->getName() << ", your " << getName() << " already reaches the highest level!";
     }
   }
 }
 
-const std::string UpgradableUnit::type() const{ return "U"; }
+// Besides the purchase, the owner is offered the next level.
+bool UpgradableUnit::pendingDecision(const Player* player, Decision& decision) const {
+  if (host_ != player) return PurchasableUnit::pendingDecision(player, decision);
+  if (level_ >= 5 || player->getMoney() < upgrade_price_) return false;
+  decision = Decision();
+  decision.kind = DecisionKind::Upgrade;
+  decision.playerId = player->getId();
+  decision.unitId = getId();
+  decision.money = player->getMoney();
+  decision.price = upgrade_price_;
+  decision.level = level_;
+  return true;
+}
 
 void UpgradableUnit::reset() {
   level_ = 1;
@@ -166,22 +204,22 @@ const int UpgradableUnit::getFine() const {
 
 // ================== Random Cost Unit ====================
 RandomCostUnit::RandomCostUnit(int id, const std::string& name, int numPlayers, int price, int finePerPoint)
-  : PurchasableUnit(id, name, numPlayers, price), finePerPoint_(finePerPoint) {}
+  : PurchasableUnit(id, UnitKind::RandomCost, name, numPlayers, price), finePerPoint_(finePerPoint) {}
 
-void RandomCostUnit::onVisit(Player* player) {
+void RandomCostUnit::onVisit(Player* player, VisitContext& ctx) {
+  INSTRUMENT_SCOPE(VisitRandomCost);
   if (!host_) {
-    tryToBuy(player);
+    tryToBuy(player, ctx);
   }
   else if (host_ != player) {
-    int dice = rand() % 6 + 1;
+    int dice = ctx.rng->rollDie();
     int total_fine = dice * finePerPoint_;
-    std::cout << player->getName() << ", you must pay $" << total_fine << " to Player " << host_->getId() << " (" << host_->getName() << ")";
+    if (ctx.out) *ctx.out << player->getName() << ", you must pay $" << total_fine << " to Player " << host_->getId() << " (" << host_->getName() << ")";
     int payment = player->pay(total_fine);
     host_->receive(payment);
   }
 }
 
-const std::string RandomCostUnit::type() const { return "R"; }
 void RandomCostUnit::reset() { setHost(nullptr); }
 
 const std::string RandomCostUnit::display() const {
@@ -195,22 +233,22 @@ const std::string RandomCostUnit::display() const {
 
 // ================== Collectable Unit ====================
 CollectableUnit::CollectableUnit(int id, const std::string& name, int numPlayers, int price, int unitFine)
-    : PurchasableUnit(id, name, numPlayers, price), unitFine_(unitFine) {}
+    : PurchasableUnit(id, UnitKind::Collectable, name, numPlayers, price), unitFine_(unitFine) {}
 
-void CollectableUnit::onVisit(Player* player) {
+void CollectableUnit::onVisit(Player* player, VisitContext& ctx) {
+  INSTRUMENT_SCOPE(VisitCollectable);
   if (!host_) {
-    tryToBuy(player);
+    tryToBuy(player, ctx);
   }
   else if (host_ != player) {
       int num_owned = host_->getNumCollectableUnits();
       int fine = num_owned * unitFine_; // Fine depends on how many the owner has
-      std::cout << player->getName() << ", you must pay $" << fine << " to Player " << host_->getId() << " (" << host_->getName() << ")";
+      if (ctx.out) *ctx.out << player->getName() << ", you must pay $" << fine << " to Player " << host_->getId() << " (" << host_->getName() << ")";
       int payment = player->pay(fine);
       host_->receive(payment);
   }
 }
 
-const std::string CollectableUnit::type() const { return "C"; }
 void CollectableUnit::reset() { setHost(nullptr); }
 
 const std::string CollectableUnit::display() const {
@@ -224,14 +262,14 @@ const std::string CollectableUnit::display() const {
 
 
 // ================== Jail Unit ====================
-JailUnit::JailUnit(int id, const std::string& name, int numPlayers) : MapUnit(id, name, numPlayers) {}
+JailUnit::JailUnit(int id, const std::string& name, int numPlayers) : MapUnit(id, UnitKind::Jail, name, numPlayers) {}
 
-void JailUnit::onVisit(Player* player) {
-    std::cout << player->getName() << " is visiting the Jail. He (She) will be frozen for one round.";
+void JailUnit::onVisit(Player* player, VisitContext& ctx) {
+    INSTRUMENT_SCOPE(VisitJail);
+    if (ctx.out) *ctx.out << player->getName() << " is visiting the Jail. He (She) will be frozen for one round.";
     player->setToJail(); // Player is frozen for one round
 }
 
-const std::string JailUnit::type() const { return "J"; }
 
 
 const std::string JailUnit::display() const {
@@ -242,41 +280,113 @@ const std::string JailUnit::display() const {
   return oss.str();
 }
 
-// ================== World Map ====================
-WorldMap::WorldMap(int numPlayers) {
-  std::ifstream in("map.dat");
-  if (!in) {
-      std::cerr << "Failed to open map.dat\n";
-      return;
+// ================== Unit Spec ====================
+bool parseMapLine(const std::string& line, UnitSpec& spec, std::string& error) {
+  std::istringstream iss(line);
+  char type;
+  iss >> type >> spec.name;
+  if (!iss) {
+    error = "expected '<type> <name> ...'";
+    return false;
   }
 
-  std::string line;
-  int id = 0;
+  int expected = 0;
+  int* fields[7] = {nullptr};
+  if (type == 'U') {
+    spec.kind = UnitKind::Upgradable;
+    fields[0] = &spec.price;
+    fields[1] = &spec.upgradePrice;
+    for (int i = 0; i < 5; ++i) fields[2 + i] = &spec.fines[i];
+    expected = 7;
+  }
+  else if (type == 'C' || type == 'R') {
+    spec.kind = (type == 'C') ? UnitKind::Collectable : UnitKind::RandomCost;
+    fields[0] = &spec.price;
+    fields[1] = &spec.param;
+    expected = 2;
+  }
+  else if (type == 'J') {
+    spec.kind = UnitKind::Jail;
+  }
+  else {
+    error = std::string("unknown unit type '") + type + "'";
+    return false;
+  }
 
-  while (std::getline(in, line)) {
-    std::istringstream iss(line);
-    char type;
-    std::string name;
-    iss >> type >> name;
-
-    if (type == 'U') {
-      int price, upgrade_price, fines[5];
-      iss >> price >> upgrade_price;
-      for (int i = 0; i < 5; ++i) iss >> fines[i];
-      units_.push_back(new UpgradableUnit(id++, name, numPlayers, price, upgrade_price, fines));
+  for (int i = 0; i < expected; ++i) {
+    if (!(iss >> *fields[i])) {
+      error = "expected " + std::to_string(expected) + " numbers after the name, got " + std::to_string(i);
+      return false;
     }
-    else if (type == 'C') { // Handle Collectable type
-      int price, unitFine;
-      iss >> price >> unitFine;
-      units_.push_back(new CollectableUnit(id++, name, numPlayers, price, unitFine));
+    if (*fields[i] < 0) {
+      error = "negative value " + std::to_string(*fields[i]);
+      return false;
     }
-    else if (type == 'R') { // Handle RandomCost type
-      int price, finePerPoint;
-      iss >> price >> finePerPoint;
-      units_.push_back(new RandomCostUnit(id++, name, numPlayers, price, finePerPoint));
+  }
+  std::string extra;
+  if (iss >> extra) {
+    error = "unexpected '" + extra + "' at end of line";
+    return false;
+  }
+  return true;
+}
+
+bool parseMapFile(const std::string& path, std::vector<UnitSpec>& specs, std::vector<std::string>& errors) {
+  std::ifstream in(path);
+  if (!in) {
+    errors.push_back("Failed to open " + path);
+    return false;
+  }
+
+  std::string line;
+  int lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    UnitSpec spec;
+    std::string error;
+    if (parseMapLine(line, spec, error)) {
+      specs.push_back(spec);
+    } else {
+      errors.push_back(path + ":" + std::to_string(lineNo) + ": " + error);
     }
-    else if (type == 'J') { // Handle Jail type
-      units_.push_back(new JailUnit(id++, name, numPlayers));
+  }
+  return true;
+}
+
+// ================== World Map ====================
+WorldMap::WorldMap(int numPlayers, const std::string& path) {
+  std::vector<UnitSpec> specs;
+  std::vector<std::string> errors;
+  parseMapFile(path, specs, errors);
+  // Malformed lines are skipped as before, but no longer silently.
+  for (const auto& error : errors) {
+    std::cerr << error << "\n";
+  }
+  build(numPlayers, specs);
+}
+
+WorldMap::WorldMap(int numPlayers, const std::vector<UnitSpec>& specs) {
+  build(numPlayers, specs);
+}
+
+void WorldMap::build(int numPlayers, const std::vector<UnitSpec>& specs) {
+  units_.reserve(specs.size());
+  int id = 0;
+  for (const auto& spec : specs) {
+    switch (spec.kind) {
+    case UnitKind::Upgradable:
+      units_.push_back(new UpgradableUnit(id++, spec.name, numPlayers, spec.price, spec.upgradePrice, spec.fines));
+      break;
+    case UnitKind::Collectable:
+      units_.push_back(new CollectableUnit(id++, spec.name, numPlayers, spec.price, spec.param));
+      break;
+    case UnitKind::RandomCost:
+      units_.push_back(new RandomCostUnit(id++, spec.name, numPlayers, spec.price, spec.param));
+      break;
+    case UnitKind::Jail:
+      units_.push_back(new JailUnit(id++, spec.name, numPlayers));
+      break;
     }
   }
 }
@@ -287,6 +397,64 @@ WorldMap::~WorldMap() {
   }
 }
 
+void WorldMap::reset() {
+  for (auto unit : units_) {
+      unit->reset();
+      unit->clearPlayersHere();
+  }
+}
+
+uint32_t WorldMap::fingerprint() const {
+  uint32_t hash = kFingerprintSeed;
+  for (auto unit : units_) {
+    int price = unit->isPurchasable() ? static_cast<PurchasableUnit*>(unit)->getPrice() : 0;
+    hash = fingerprintUnit(hash, static_cast<int>(unit->kind()), price);
+  }
+  return hash;
+}
+
+bool WorldMap::save(GameState& state) const {
+  if (units_.size() > size_t(kMaxStateUnits)) return false;
+  state.unitCount = units_.size();
+  state.units.resize(units_.size());
+  state.boardFingerprint = fingerprint();
+  for (size_t i = 0; i < units_.size(); ++i) {
+    UnitSnapshot& snap = state.units[i];
+    snap.owner = -1;
+    snap.level = 1;
+    if (units_[i]->isPurchasable()) {
+      const Player* host = static_cast<PurchasableUnit*>(units_[i])->getHost();
+      if (host) snap.owner = host->getId();
+    }
+    if (units_[i]->kind() == UnitKind::Upgradable) {
+      snap.level = static_cast<UpgradableUnit*>(units_[i])->getLevel();
+    }
+  }
+  return true;
+}
+
+bool WorldMap::restore(const GameState& state, WorldPlayer& players) {
+  if (state.unitCount != units_.size() || state.boardFingerprint != fingerprint()) return false;
+  reset();
+  for (size_t i = 0; i < units_.size(); ++i) {
+    const UnitSnapshot& snap = state.units[i];
+    Player* host = players.playerNow(snap.owner);
+    if (host && units_[i]->isPurchasable()) {
+      auto* unit = static_cast<PurchasableUnit*>(units_[i]);
+      unit->setHost(host);
+      host->addUnit(unit);
+      if (unit->kind() == UnitKind::Upgradable) {
+        static_cast<UpgradableUnit*>(unit)->setLevel(snap.level);
+      }
+    }
+  }
+  for (int i = 0; i < players.getPlayerCount(); ++i) {
+    Player* p = players.playerNow(i);
+    if (MapUnit* here = getUnit(p->getLocation())) here->addPlayerHere(p);
+  }
+  return true;
+}
+
 MapUnit* WorldMap::getUnit(int index) const {
   return (index >= 0 && index < units_.size()) ? units_[index] : nullptr;
 }
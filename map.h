@@ -1,36 +1,73 @@
 #ifndef MAP__
 #define MAP__
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <iostream>
 
-// Forward declare Player class
+// Forward declare Player & DecisionPolicy class
 class Player;
+class WorldPlayer;
+struct GameState;
+class DecisionPolicy;
+struct Decision;
+class Rng;
+
+// Services handed to onVisit by the engine: who answers the buy/upgrade
+// questions, and where the narration goes (nullptr when running headless).
+struct VisitContext {
+  DecisionPolicy* policy = nullptr;
+  std::ostream* out = nullptr;
+  Rng* rng = nullptr; // the game's own dice stream, never the global rand()
+};
+
+// What a unit is, as a plain tag: cheap to store, compare and switch on.
+enum class UnitKind : uint8_t { Upgradable, Collectable, RandomCost, Jail };
+const int kNumUnitKinds = 4;
+
+// Up to this many seats a unit shows one column per seat ("=0 2="); with
+// more it shows how many players stand on it.
+const int kMaxSeatColumns = 8;
 
 // ===== MapUnit (base class) =====
+// Who stands on a unit is kept as a count plus one bit per seat for the
+// first 64 seats, so a unit costs the same whatever the number of players
+// and moving a player is O(1). Where each player is lives in the players
+// themselves (Player::getLocation).
 class MapUnit {
 protected:
   int id_ = 0;
+  UnitKind kind_ = UnitKind::Jail;
+  uint8_t seatColumns_ = 0;   // players shown per seat, 0 when too many
+  int playersHere_ = 0;
+  uint64_t seatsHere_ = 0;    // bit i: seat i (< 64) is here
   std::string name_;
-  std::vector<Player*> playersHerePtrs_;
   std::string getPlayersHereString() const;
 public:
-  MapUnit(int id, const std::string& name, int numPlayers);
+  MapUnit(int id, UnitKind kind, const std::string& name, int numPlayers);
   virtual ~MapUnit() = default;
 
-  virtual void onVisit(Player* player) = 0;
-  virtual const std::string type() const = 0;
+  virtual void onVisit(Player* player, VisitContext& ctx) = 0;
+  // One-letter map.dat tag ("U", "C", "R", "J"); no allocation.
+  const std::string& type() const;
   virtual void reset() {}
   virtual bool isPurchasable() const { return false; }
   virtual const std::string display() const;
+  // The buy/upgrade question onVisit would ask this player, if any. Lets a
+  // frontend collect the answer before running the visit.
+  virtual bool pendingDecision(const Player* /*player*/, Decision& /*decision*/) const { return false; }
 
   const int getId() const { return id_; }
+  const UnitKind kind() const { return kind_; }
   const std::string getName() const { return name_; }
 
   void addPlayerHere(Player* p);
   void removePlayerHere(Player* p);
-  const std::vector<Player*>& getPlayersHere() const;
+  void clearPlayersHere();
+  const int getPlayerCountHere() const { return playersHere_; }
+  // Only answers for seats below 64.
+  bool isSeatHere(int id) const { return id >= 0 && id < 64 && (seatsHere_ >> id) & 1; }
 };
 
 // ================== Purchasable Unit ====================
@@ -38,13 +75,14 @@ class PurchasableUnit : public MapUnit {
 protected:
     int price_ = 0;
     Player* host_ = nullptr;
-    void tryToBuy(Player* player);
+    void tryToBuy(Player* player, VisitContext& ctx);
 public:
-    PurchasableUnit(int id, const std::string& name, int numPlayers, int price);
+    PurchasableUnit(int id, UnitKind kind, const std::string& name, int numPlayers, int price);
     ~PurchasableUnit() = default;
 
     bool isPurchasable() const override { return true; }
     const std::string display() const override;
+    bool pendingDecision(const Player* player, Decision& decision) const override;
 
     const int getPrice() const { return price_; }
     const Player* getHost() const { return host_; }
@@ -62,13 +100,15 @@ private:
 public:
   UpgradableUnit(int id, const std::string& name, int numPlayers, int price, int upgrade_price, const int* fines);
 
-  void onVisit(Player* player) override;
-  const std::string type() const override;
+  void onVisit(Player* player, VisitContext& ctx) override;
   void reset() override;
   const std::string display() const override;
+  bool pendingDecision(const Player* player, Decision& decision) const override;
 
   void upgrade();
+  void setLevel(int level) { level_ = (level < 1) ? 1 : (level > 5 ? 5 : level); }
   const int getFine() const;
+  const int getFineAtLevel(int level) const { return fines_[level - 1]; }
   const int getUpgradePrice() const;
   const int getLevel() const;
 };
@@ -81,10 +121,11 @@ private:
 public:
   RandomCostUnit(int id, const std::string& name, int numPlayers, int price, int finePerPoint);
 
-  void onVisit(Player* player) override;
-  const std::string type() const override;
+  void onVisit(Player* player, VisitContext& ctx) override;
   void reset() override;
   const std::string display() const override;
+
+  const int getFinePerPoint() const { return finePerPoint_; }
 };
 
 // ================== Collectable Unit ====================
@@ -94,31 +135,63 @@ private:
 
 public:
     CollectableUnit(int id, const std::string& name, int numPlayers, int price, int unitFine);
-    void onVisit(Player* player) override;
-    const std::string type() const override;
+    void onVisit(Player* player, VisitContext& ctx) override;
     void reset() override;
     const std::string display() const override;
+
+    const int getUnitFine() const { return unitFine_; }
 };
 
 // ================== Jail Unit ====================
 class JailUnit : public MapUnit {
 public:
     JailUnit(int id, const std::string& name, int numPlayers);
-    void onVisit(Player* player) override;
-    const std::string type() const override;
+    void onVisit(Player* player, VisitContext& ctx) override;
     const std::string display() const override;
 };
 
+// ================== Unit Spec ====================
+// One line of map.dat as plain data, before any unit object exists.
+struct UnitSpec {
+  UnitKind kind = UnitKind::Jail;
+  std::string name;
+  int price = 0;
+  int upgradePrice = 0;   // U only
+  int param = 0;          // unitFine (C) or finePerPoint (R)
+  int fines[5] = {0};     // U only, level 1..5
+};
+
+// Parses map.dat text. Blank lines are skipped; every malformed line
+// (unknown type, missing or negative numbers, trailing junk) is reported in
+// errors as "line N: ..." and left out. Returns false if the file cannot be
+// opened.
+bool parseMapFile(const std::string& path, std::vector<UnitSpec>& specs, std::vector<std::string>& errors);
+bool parseMapLine(const std::string& line, UnitSpec& spec, std::string& error);
+
 // ================== World Map ====================
 class WorldMap {
 private:
   std::vector<MapUnit*> units_;
 public:
-  WorldMap(int numPlayers);
+  WorldMap(int numPlayers, const std::string& path = "map.dat");
+  WorldMap(int numPlayers, const std::vector<UnitSpec>& specs);
   ~WorldMap();
 
+  // Puts every unit back on the market and empties the board.
+  void reset();
+
+  // Ownership and levels to/from a snapshot. restore() expects the players
+  // to have been restored first (WorldPlayer::restore) and rebuilds their
+  // owned units and everybody's position on the board.
+  bool save(GameState& state) const;
+  bool restore(const GameState& state, WorldPlayer& players);
+  uint32_t fingerprint() const;
+
   MapUnit* getUnit(int index) const;
   const int getUnitCount() const;
+
+private:
+  void build(int numPlayers, const std::vector<UnitSpec>& specs);
 };
 
 #endif
@@ -0,0 +1,205 @@
+#include "map_image.h"
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+const char kMagic[8] = {'M', 'O', 'N', 'O', 'M', 'A', 'P', '\0'};
+
+uint32_t fnv1a(const unsigned char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+uint32_t align8(size_t n) {
+    return uint32_t((n + 7) & ~size_t(7));
+}
+
+template <class T>
+void put(std::vector<char>& out, uint32_t offset, const T* values, size_t count) {
+    std::memcpy(out.data() + offset, values, sizeof(T) * count);
+}
+
+} // namespace
+
+// ================== Map Image ==================
+MapImage::~MapImage() {
+    close();
+}
+
+bool MapImage::write(const std::string& path, const std::vector<UnitSpec>& specs, std::string& error) {
+    const uint32_t n = specs.size();
+
+    std::vector<uint8_t> kinds(n);
+    std::vector<int32_t> prices(n), upgrades(n), params(n), fines(n * 5);
+    std::vector<uint32_t> nameIndex(n + 1);
+    std::string names;
+    for (uint32_t u = 0; u < n; ++u) {
+        const UnitSpec& spec = specs[u];
+        kinds[u] = static_cast<uint8_t>(spec.kind);
+        prices[u] = spec.price;
+        upgrades[u] = spec.upgradePrice;
+        params[u] = spec.param;
+        for (int l = 0; l < 5; ++l) fines[u * 5 + l] = spec.fines[l];
+        nameIndex[u] = names.size();
+        names += spec.name;
+    }
+    nameIndex[n] = names.size();
+
+    MapImageHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.unitCount = n;
+    header.kindOffset = align8(sizeof(MapImageHeader));
+    header.priceOffset = align8(header.kindOffset + n);
+    header.upgradeOffset = align8(header.priceOffset + 4 * n);
+    header.paramOffset = align8(header.upgradeOffset + 4 * n);
+    header.finesOffset = align8(header.paramOffset + 4 * n);
+    header.nameIndexOffset = align8(header.finesOffset + 20 * n);
+    header.namesOffset = align8(header.nameIndexOffset + 4 * (n + 1));
+    header.namesSize = names.size();
+    header.fileSize = align8(header.namesOffset + names.size());
+
+    std::vector<char> out(header.fileSize, 0);
+    put(out, header.kindOffset, kinds.data(), n);
+    put(out, header.priceOffset, prices.data(), n);
+    put(out, header.upgradeOffset, upgrades.data(), n);
+    put(out, header.paramOffset, params.data(), n);
+    put(out, header.finesOffset, fines.data(), n * 5);
+    put(out, header.nameIndexOffset, nameIndex.data(), n + 1);
+    put(out, header.namesOffset, names.data(), names.size());
+    header.checksum = fnv1a(reinterpret_cast<const unsigned char*>(out.data()) + sizeof(header),
+                            out.size() - sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.data(), out.size())) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool MapImage::open(const std::string& path, std::string& error) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(MapImageHeader))) {
+        ::close(fd);
+        error = path + " is too small to be a map image";
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (data == MAP_FAILED) {
+        error = "cannot mmap " + path;
+        return false;
+    }
+
+    data_ = data;
+    size_ = st.st_size;
+    header_ = static_cast<const MapImageHeader*>(data_);
+    if (!validate(error)) {
+        error = path + ": " + error;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MapImage::close() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+}
+
+bool MapImage::validate(std::string& error) const {
+    const MapImageHeader& h = *header_;
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "not a map image (bad magic)";
+        return false;
+    }
+    if (h.version != kVersion) {
+        error = "unsupported image version " + std::to_string(h.version);
+        return false;
+    }
+    if (h.fileSize != size_) {
+        error = "truncated image";
+        return false;
+    }
+
+    // Every section must be aligned and fit inside the file.
+    const uint64_t n = h.unitCount;
+    const struct { uint32_t offset; uint64_t bytes; } sections[] = {
+        {h.kindOffset, n}, {h.priceOffset, 4 * n}, {h.upgradeOffset, 4 * n},
+        {h.paramOffset, 4 * n}, {h.finesOffset, 20 * n},
+        {h.nameIndexOffset, 4 * (n + 1)}, {h.namesOffset, h.namesSize},
+    };
+    for (const auto& s : sections) {
+        if (s.offset % 8 != 0 || s.offset < sizeof(MapImageHeader) || s.offset + s.bytes > size_) {
+            error = "section out of bounds";
+            return false;
+        }
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data_);
+    if (fnv1a(bytes + sizeof(MapImageHeader), size_ - sizeof(MapImageHeader)) != h.checksum) {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    const uint8_t* kind = section<uint8_t>(h.kindOffset);
+    const uint32_t* nameIndex = section<uint32_t>(h.nameIndexOffset);
+    for (uint32_t u = 0; u < n; ++u) {
+        if (kind[u] >= kNumUnitKinds) {
+            error = "unit " + std::to_string(u) + " has unknown kind";
+            return false;
+        }
+        if (nameIndex[u] > nameIndex[u + 1]) {
+            error = "unit " + std::to_string(u) + " has a bad name offset";
+            return false;
+        }
+    }
+    if (nameIndex[n] > h.namesSize) {
+        error = "name table out of bounds";
+        return false;
+    }
+    return true;
+}
+
+std::string_view MapImage::name(int unit) const {
+    const uint32_t* nameIndex = section<uint32_t>(header_->nameIndexOffset);
+    return std::string_view(section<char>(header_->namesOffset) + nameIndex[unit],
+                            nameIndex[unit + 1] - nameIndex[unit]);
+}
+
+std::vector<UnitSpec> MapImage::toSpecs() const {
+    std::vector<UnitSpec> specs(getUnitCount());
+    for (int u = 0; u < getUnitCount(); ++u) {
+        UnitSpec& spec = specs[u];
+        spec.kind = kinds()[u];
+        spec.name = std::string(name(u));
+        spec.price = prices()[u];
+        spec.upgradePrice = upgradePrices()[u];
+        spec.param = params()[u];
+        for (int l = 0; l < 5; ++l) spec.fines[l] = fines()[u * 5 + l];
+    }
+    return specs;
+}
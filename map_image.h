@@ -0,0 +1,87 @@
+#ifndef MAP_IMAGE__
+#define MAP_IMAGE__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "map.h"
+
+// ================== Map Image ==================
+// Compiled board produced by `mapc`: the unit definitions of a map.dat laid
+// out as struct-of-arrays sections in one file, so a loader can mmap it and
+// use the arrays in place. Integers are in host byte order (images are not
+// meant to travel between machines); every section starts on an 8-byte
+// boundary.
+//
+//   header   MapImageHeader
+//   kind     uint8_t  [unitCount]
+//   price    int32_t  [unitCount]
+//   upgrade  int32_t  [unitCount]
+//   param    int32_t  [unitCount]      unitFine (C) / finePerPoint (R)
+//   fines    int32_t  [unitCount * 5]
+//   nameIdx  uint32_t [unitCount + 1]  offsets into names
+//   names    char     [namesSize]
+struct MapImageHeader {
+    char magic[8];            // "MONOMAP\0"
+    uint32_t version;
+    uint32_t unitCount;
+    uint32_t fileSize;
+    uint32_t checksum;        // FNV-1a of every byte after the header
+    uint32_t kindOffset;
+    uint32_t priceOffset;
+    uint32_t upgradeOffset;
+    uint32_t paramOffset;
+    uint32_t finesOffset;
+    uint32_t nameIndexOffset;
+    uint32_t namesOffset;
+    uint32_t namesSize;
+    uint32_t reserved[2];
+};
+
+class MapImage {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    MapImage() = default;
+    ~MapImage();
+    MapImage(const MapImage&) = delete;
+    MapImage& operator=(const MapImage&) = delete;
+
+    // Serializes specs into the image format. Returns false and sets error
+    // if the file cannot be written.
+    static bool write(const std::string& path, const std::vector<UnitSpec>& specs, std::string& error);
+
+    // Maps the file read-only and validates it (magic, version, section
+    // bounds, unit kinds, name offsets, checksum). On failure the image
+    // stays empty and error says why.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool isOpen() const { return header_ != nullptr; }
+    int getUnitCount() const { return header_ ? header_->unitCount : 0; }
+
+    // Views straight into the mapping; valid while the image is open.
+    const UnitKind* kinds() const { return section<UnitKind>(header_->kindOffset); }
+    const int32_t* prices() const { return section<int32_t>(header_->priceOffset); }
+    const int32_t* upgradePrices() const { return section<int32_t>(header_->upgradeOffset); }
+    const int32_t* params() const { return section<int32_t>(header_->paramOffset); }
+    const int32_t* fines() const { return section<int32_t>(header_->finesOffset); }
+    std::string_view name(int unit) const;
+
+    std::vector<UnitSpec> toSpecs() const;
+
+private:
+    template <class T>
+    const T* section(uint32_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(data_) + offset);
+    }
+    bool validate(std::string& error) const;
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    const MapImageHeader* header_ = nullptr;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "map_watch.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+
+namespace {
+
+const char* const kKindTags[kNumUnitKinds] = {"U", "C", "R", "J"};
+
+// What UnitSpec::param means for each kind.
+const char* paramName(UnitKind kind) {
+    return kind == UnitKind::Collectable ? "unit fine" : "fine per point";
+}
+
+std::string unitLabel(size_t index, const UnitSpec& spec) {
+    return "unit " + std::to_string(index) + " (" + spec.name + ")";
+}
+
+} // namespace
+
+std::vector<std::string> diffBoards(const std::vector<UnitSpec>& from, const std::vector<UnitSpec>& to) {
+    std::vector<std::string> changes;
+    auto field = [&](size_t u, const char* name, int before, int after) {
+        if (before != after) {
+            changes.push_back(unitLabel(u, to[u]) + ": " + name + " " + std::to_string(before) + " -> " +
+                              std::to_string(after));
+        }
+    };
+    size_t common = std::min(from.size(), to.size());
+    for (size_t u = 0; u < common; ++u) {
+        const UnitSpec& a = from[u];
+        const UnitSpec& b = to[u];
+        if (a.kind != b.kind) {
+            changes.push_back(unitLabel(u, b) + ": type " + kKindTags[int(a.kind)] + " -> " + kKindTags[int(b.kind)]);
+            continue;
+        }
+        if (a.name != b.name) changes.push_back(unitLabel(u, b) + ": renamed from " + a.name);
+        field(u, "price", a.price, b.price);
+        field(u, "upgrade price", a.upgradePrice, b.upgradePrice);
+        if (a.kind == UnitKind::Collectable || a.kind == UnitKind::RandomCost) {
+            field(u, paramName(a.kind), a.param, b.param);
+        }
+        for (int l = 0; l < 5; ++l) {
+            const std::string name = "fine L" + std::to_string(l + 1);
+            field(u, name.c_str(), a.fines[l], b.fines[l]);
+        }
+    }
+    for (size_t u = common; u < to.size(); ++u) changes.push_back(unitLabel(u, to[u]) + ": added");
+    for (size_t u = common; u < from.size(); ++u) changes.push_back(unitLabel(u, from[u]) + ": removed");
+    return changes;
+}
+
+// ================== Map Watcher ==================
+MapWatcher::MapWatcher(const std::string& path, std::ostream* log) : path_(path), log_(log) {
+    size_t slash = path.rfind('/');
+    dir_ = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    file_ = slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+MapWatcher::~MapWatcher() {
+    stop();
+}
+
+bool MapWatcher::load(std::vector<std::string>& errors) {
+    auto board = std::make_shared<Board>();
+    parseMapFile(path_, board->specs, errors);
+    if (board->specs.empty()) return false;
+    board->errors = errors;
+    board->version = 1;
+    board_.store(std::move(board), std::memory_order_release);
+    return true;
+}
+
+bool MapWatcher::start() {
+    if (thread_.joinable()) return true;
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0 || inotify_add_watch(inotify_, dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        if (log_) *log_ << dir_ << ": cannot watch for map changes: " << std::strerror(errno) << "\n";
+        if (inotify_ >= 0) close(inotify_);
+        inotify_ = -1;
+        return false;
+    }
+    wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void MapWatcher::stop() {
+    if (!thread_.joinable()) return;
+    uint64_t one = 1;
+    (void)!write(wake_, &one, sizeof(one));
+    thread_.join();
+    close(inotify_);
+    close(wake_);
+    inotify_ = wake_ = -1;
+}
+
+void MapWatcher::run() {
+    alignas(inotify_event) char buf[4096];
+    pollfd fds[2] = {{inotify_, POLLIN, 0}, {wake_, POLLIN, 0}};
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        // Every event queued so far, then one reload for all of them.
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(inotify_, buf, sizeof(buf))) > 0) {
+            for (ssize_t at = 0; at < n;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buf + at);
+                if (event->len > 0 && file_ == event->name) changed = true;
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) reload();
+    }
+}
+
+void MapWatcher::reload() {
+    auto board = std::make_shared<Board>();
+    if (!parseMapFile(path_, board->specs, board->errors)) {
+        if (log_) *log_ << path_ << ": cannot read, keeping the current board\n";
+        return;
+    }
+    std::shared_ptr<const Board> live = current();
+    bool knownErrors = live && board->errors == live->errors;
+    if (!board->errors.empty() && log_) {
+        for (const auto& error : board->errors) *log_ << error << "\n";
+        if (knownErrors) *log_ << path_ << ": same malformed lines as the current board, left out as before\n";
+    }
+    if ((!board->errors.empty() && !knownErrors) || board->specs.empty()) {
+        if (log_) *log_ << path_ << ": " << (board->specs.empty() ? "no units" : "malformed") << ", keeping the current board\n";
+        return;
+    }
+
+    static const std::vector<UnitSpec> none;
+    std::vector<std::string> changes = diffBoards(live ? live->specs : none, board->specs);
+    if (changes.empty()) return;
+    board->version = (live ? live->version : 0) + 1;
+    if (log_) {
+        *log_ << path_ << ": board version " << board->version << " for new games\n";
+        for (const auto& change : changes) *log_ << "  " << change << "\n";
+    }
+    board_.store(std::move(board), std::memory_order_release);
+    reloads_.fetch_add(1, std::memory_order_relaxed);
+}
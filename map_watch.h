@@ -0,0 +1,73 @@
+#ifndef MAP_WATCH__
+#define MAP_WATCH__
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "map.h"
+
+// ================== Board ==================
+// One version of a map.dat, never changed once published. A game builds
+// its WorldMap from the version that was current when it started and keeps
+// playing that one whatever happens to the file.
+struct Board {
+    uint64_t version = 0;
+    std::vector<UnitSpec> specs;
+    std::vector<std::string> errors;   // malformed lines left out of specs
+};
+
+// What changed from one board to the next, one line per field:
+// "unit 3 (Germany): price 2000 -> 2500", "unit 12 (Tokyo): added".
+std::vector<std::string> diffBoards(const std::vector<UnitSpec>& from, const std::vector<UnitSpec>& to);
+
+// ================== Map Watcher ==================
+// Keeps the current Board of a map.dat and follows the file with inotify.
+// The directory is watched rather than the file, so editors that save by
+// renaming a new file over the old one are seen too.
+//
+// Reloads run on the watcher's own thread: the new file is parsed and
+// diffed there and published with one atomic pointer swap, so the threads
+// starting games only ever pay for current(). A file with no units, or
+// with malformed lines, is reported and the live board stays: dropping a
+// line would shift every unit after it. The one exception is a file whose
+// malformed lines are exactly those the live board was loaded with, so a
+// server started on a file with a bad line can still pick up edits. A
+// save that changes nothing keeps the live board too.
+class MapWatcher {
+public:
+    explicit MapWatcher(const std::string& path, std::ostream* log = nullptr);
+    MapWatcher(const MapWatcher&) = delete;
+    MapWatcher& operator=(const MapWatcher&) = delete;
+    ~MapWatcher();
+
+    // First load, on the caller's thread. Malformed lines are left out and
+    // reported in errors, as in parseMapFile(); false if no unit is left.
+    bool load(std::vector<std::string>& errors);
+    // Starts following the file; false if inotify is not available.
+    bool start();
+    void stop();
+
+    std::shared_ptr<const Board> current() const { return board_.load(std::memory_order_acquire); }
+    uint64_t getReloads() const { return reloads_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void reload();
+
+    std::string path_;
+    std::string dir_;
+    std::string file_;
+    std::ostream* log_;
+    std::atomic<std::shared_ptr<const Board>> board_;
+    std::atomic<uint64_t> reloads_{0};
+    int inotify_ = -1;
+    int wake_ = -1;
+    std::thread thread_;
+};
+
+#endif
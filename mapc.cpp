@@ -0,0 +1,156 @@
+// Map compiler: validates a map.dat and writes the binary board image that
+// tournament and other simulators can mmap instead of parsing text.
+//
+//   mapc map.dat map.bin      compile (fails on any malformed line)
+//   mapc --check map.bin      load, validate and time the image
+//   mapc --dump map.bin       print the image back as map.dat text
+//   mapc --header map.dat embedded_board.h
+//                             write the board as constexpr tables, for a
+//                             build with -DMONOPOLY_EMBEDDED_BOARD
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "map.h"
+#include "map_image.h"
+
+static int usage() {
+    std::cerr << "usage: mapc <map.dat> <out.bin>\n"
+                 "       mapc --check <map.bin>\n"
+                 "       mapc --dump <map.bin>\n"
+                 "       mapc --header <map.dat> <out.h>\n";
+    return 1;
+}
+
+// Fails on any malformed line, like compile().
+static bool parseStrict(const std::string& in, std::vector<UnitSpec>& specs) {
+    std::vector<std::string> errors;
+    parseMapFile(in, specs, errors);
+    if (specs.empty() && errors.empty()) {
+        errors.push_back(in + ": no units");
+    }
+    for (const auto& error : errors) std::cerr << error << "\n";
+    return errors.empty();
+}
+
+static int compile(const std::string& in, const std::string& out) {
+    std::vector<UnitSpec> specs;
+    if (!parseStrict(in, specs)) return 1;
+
+    std::string error;
+    if (!MapImage::write(out, specs, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    std::cout << out << ": " << specs.size() << " units\n";
+    return 0;
+}
+
+static int check(const std::string& path) {
+    MapImage image;
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = image.open(path, error);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (!ok) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    std::cout << path << ": " << image.getUnitCount() << " units, loaded in "
+              << std::chrono::duration<double, std::micro>(elapsed).count() << " us\n";
+    return 0;
+}
+
+static int dump(const std::string& path) {
+    MapImage image;
+    std::string error;
+    if (!image.open(path, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    for (const auto& spec : image.toSpecs()) {
+        switch (spec.kind) {
+        case UnitKind::Upgradable:
+            std::cout << "U " << spec.name << " " << spec.price << " " << spec.upgradePrice;
+            for (int fine : spec.fines) std::cout << " " << fine;
+            break;
+        case UnitKind::Collectable:
+            std::cout << "C " << spec.name << " " << spec.price << " " << spec.param;
+            break;
+        case UnitKind::RandomCost:
+            std::cout << "R " << spec.name << " " << spec.price << " " << spec.param;
+            break;
+        case UnitKind::Jail:
+            std::cout << "J " << spec.name;
+            break;
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+static std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// One table per field, in the layout static_game.h expects.
+static int header(const std::string& in, const std::string& out) {
+    std::vector<UnitSpec> specs;
+    if (!parseStrict(in, specs)) return 1;
+
+    std::ofstream h(out, std::ios::trunc);
+    if (!h) {
+        std::cerr << out << ": cannot write\n";
+        return 1;
+    }
+    static const char* const kindNames[kNumUnitKinds] = {
+        "UnitKind::Upgradable", "UnitKind::Collectable", "UnitKind::RandomCost", "UnitKind::Jail"};
+    auto row = [&](const char* type, const char* name, auto field) {
+        h << "    static constexpr " << type << " " << name << "[kUnitCount] = {";
+        for (size_t u = 0; u < specs.size(); ++u) {
+            h << (u % 8 == 0 ? "\n        " : " ") << field(specs[u]) << ",";
+        }
+        h << "\n    };\n";
+    };
+
+    h << "// Generated by `mapc --header " << in << " " << out << "`; do not edit.\n"
+      << "#ifndef EMBEDDED_BOARD__\n#define EMBEDDED_BOARD__\n\n"
+      << "#include <cstdint>\n\n#include \"map.h\"\n\n"
+      << "struct EmbeddedBoard {\n"
+      << "    static constexpr int kUnitCount = " << specs.size() << ";\n";
+    row("UnitKind", "kKind", [&](const UnitSpec& s) { return std::string(kindNames[int(s.kind)]); });
+    row("int32_t", "kPrice", [](const UnitSpec& s) { return std::to_string(s.price); });
+    row("int32_t", "kUpgradePrice", [](const UnitSpec& s) { return std::to_string(s.upgradePrice); });
+    row("int32_t", "kParam", [](const UnitSpec& s) { return std::to_string(s.param); });
+    h << "    static constexpr int32_t kFines[kUnitCount][5] = {\n";
+    for (const UnitSpec& s : specs) {
+        h << "        {" << s.fines[0] << ", " << s.fines[1] << ", " << s.fines[2] << ", "
+          << s.fines[3] << ", " << s.fines[4] << "},\n";
+    }
+    h << "    };\n";
+    row("const char*", "kName", [](const UnitSpec& s) { return quoted(s.name); });
+    h << "};\n\n#endif\n";
+    if (!h) {
+        std::cerr << out << ": write failed\n";
+        return 1;
+    }
+    std::cout << out << ": " << specs.size() << " units\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && std::string(argv[1]) == "--header") return header(argv[2], argv[3]);
+    if (argc != 3) return usage();
+    std::string first = argv[1];
+    if (first == "--check") return check(argv[2]);
+    if (first == "--dump") return dump(argv[2]);
+    if (first[0] == '-') return usage();
+    return compile(first, argv[2]);
+}
@@ -0,0 +1,85 @@
+#include "markov.h"
+#include <algorithm>
+#include <cmath>
+
+
+// ================== Landing Chain ==================
+LandingChain::LandingChain(const BoardLayout& board)
+    : n_(board.unitCount), movable_(n_), free_(n_), frozen_(n_),
+      window_(n_ + 6), land_(n_), landing_(n_) {
+    for (int u = 0; u < n_; ++u) {
+        movable_[u] = board.kind[u] == UnitKind::Jail ? 0.0 : 1.0;
+    }
+}
+
+double LandingChain::step() {
+    const int n = n_;
+    for (int i = 0; i < 6; ++i) {
+        window_[i] = free_[((i - 6) % n + n) % n];
+    }
+    std::copy(free_.begin(), free_.end(), window_.begin() + 6);
+
+    const double* w = window_.data();
+    const double* movable = movable_.data();
+    double* free = free_.data();
+    double* frozen = frozen_.data();
+    double* land = land_.data();
+    double change = 0;
+    for (int u = 0; u < n; ++u) {
+        double l = (w[u] + w[u + 1] + w[u + 2] + w[u + 3] + w[u + 4] + w[u + 5]) * (1.0 / 6.0);
+        // A frozen player moves back to free on the spot; a jail landing
+        // freezes, anything else leaves the player free to roll next turn.
+        double nextFree = l * movable[u] + frozen[u];
+        double nextFrozen = l - l * movable[u];
+        change += std::fabs(nextFree - free[u]) + std::fabs(nextFrozen - frozen[u]);
+        land[u] = l;
+        free[u] = nextFree;
+        frozen[u] = nextFrozen;
+    }
+    return change;
+}
+
+bool LandingChain::solveStationary(double tolerance, int maxIterations) {
+    int jails = 0;
+    for (int u = 0; u < n_; ++u) {
+        if (movable_[u] == 0.0) ++jails;
+    }
+    const double share = 1.0 / (n_ + jails);
+    for (int u = 0; u < n_; ++u) {
+        free_[u] = share;
+        frozen_[u] = movable_[u] == 0.0 ? share : 0.0;
+    }
+
+    iterations_ = 0;
+    residual_ = 0;
+    do {
+        residual_ = step();
+        ++iterations_;
+    } while (residual_ > tolerance && iterations_ < maxIterations);
+
+    // land_ holds the landings of the last step; the frozen mass is the
+    // share of turns that end without one.
+    frozenShare_ = 0;
+    for (int u = 0; u < n_; ++u) {
+        frozenShare_ += frozen_[u];
+    }
+    landing_ = land_;
+    return residual_ <= tolerance;
+}
+
+void LandingChain::solveOpening(int turns) {
+    std::fill(free_.begin(), free_.end(), 0.0);
+    std::fill(frozen_.begin(), frozen_.end(), 0.0);
+    std::fill(landing_.begin(), landing_.end(), 0.0);
+    free_[0] = 1.0;
+
+    for (int t = 0; t < turns; ++t) {
+        step();
+        for (int u = 0; u < n_; ++u) {
+            landing_[u] += land_[u];
+        }
+    }
+    iterations_ = turns;
+    residual_ = 0;
+    frozenShare_ = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef MARKOV__
+#define MARKOV__
+
+#include <vector>
+
+#include "fast_game.h"
+
+// ================== Landing Chain ==================
+// One player's movement as a Markov chain, independent of money and
+// ownership: each turn the player either rolls one die and moves 1..6
+// units (wrapping around the board), or, after landing on a Jail unit,
+// stays frozen for that turn. States are (unit, frozen), so the chain has
+// 2 * unitCount states and the transition matrix is a band of width 6.
+//
+// A step applies the matrix to the whole distribution with a sliding
+// window over a copy of the "free" states padded by the wrap-around, which
+// keeps the inner loop a straight pass over contiguous doubles that the
+// compiler vectorizes.
+class LandingChain {
+public:
+    explicit LandingChain(const BoardLayout& board);
+
+    // Power iteration to the long-run distribution. The start vector is
+    // the fixed point of the walk without jail freezes (every unit equally
+    // likely, plus one frozen turn per jail landing), so it converges in a
+    // few steps; the iteration corrects for anything the guess misses.
+    // Returns false if the L1 change per step is still above tolerance
+    // after maxIterations.
+    bool solveStationary(double tolerance = 1e-13, int maxIterations = 100000);
+
+    // Expected number of landings on each unit during the first `turns`
+    // turns of a game, starting from unit 0. Closer to what a short game
+    // sees than the long-run figures.
+    void solveOpening(int turns);
+
+    // Per unit: probability that a turn ends with a landing there
+    // (stationary), or expected landings (opening).
+    const std::vector<double>& getLanding() const { return landing_; }
+    // Share of turns spent frozen in jail (stationary only).
+    double getFrozenShare() const { return frozenShare_; }
+    int getIterations() const { return iterations_; }
+    double getResidual() const { return residual_; }
+
+private:
+    // Advances free_/frozen_ one turn and writes this turn's landings to
+    // land_. Returns the L1 distance between the old and new distribution.
+    double step();
+
+    int n_;
+    std::vector<double> movable_;   // 1 for units that let the player move on, 0 for jail
+    std::vector<double> free_;
+    std::vector<double> frozen_;
+    std::vector<double> window_;    // free_ with the last 6 units copied in front
+    std::vector<double> land_;
+    std::vector<double> landing_;
+    double frozenShare_ = 0;
+    int iterations_ = 0;
+    double residual_ = 0;
+};
+
+#endif
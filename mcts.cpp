@@ -0,0 +1,290 @@
+#include "mcts.h"
+#include "zobrist.h"
+#include <cmath>
+#include <thread>
+#include <unordered_map>
+
+
+namespace {
+
+const int32_t kNone = -1;
+const size_t kMaxNodes = 1 << 20;
+
+// What a decision node stands for: the question, not the dice behind it.
+uint32_t contextKey(const Decision& d) {
+    return (uint32_t(d.kind) << 24) | uint32_t(d.unitId);
+}
+
+// The transposition table key: the question in this exact state.
+uint64_t stateKey(const FastGame& game, const Decision& d) {
+    return game.getHash() ^ zobrist::key(zobrist::Decision, contextKey(d));
+}
+
+} // namespace
+
+// ================== Searcher ==================
+// One search thread's private world: its tree, its FastGame and the
+// policies that drive the rollouts.
+class MctsPolicy::Searcher : public DecisionPolicy {
+public:
+    Searcher(const BoardLayout& board, int numPlayers, const Options& options, uint64_t stream)
+        : board_(board), options_(options), game_(board, numPlayers),
+          opponents_(options.opponentReserve), own_(options.rolloutReserve),
+          streamBase_(stream << 40) {
+        for (int i = 0; i < numPlayers; ++i) {
+            game_.setPolicy(i, this);
+        }
+    }
+
+    // Makes the node for this decision the root, reusing the subtree below
+    // the previous answer (or, with transpositions, the node of this very
+    // state) when the search already got there.
+    void beginDecision(const GameState& state, const Decision& decision) {
+        me_ = decision.playerId;
+        uint32_t key = contextKey(decision);
+        int32_t root = kNone;
+        if (options_.transpositions) {
+            if (nodes_.size() > kMaxNodes / 2) {
+                nodes_.clear();
+                table_.clear();
+            }
+            game_.restore(state);
+            root_ = transposition(decision);
+            rollouts_ = 0;
+            return;
+        }
+        if (lastRoot_ != kNone) {
+            for (int32_t c = nodes_[lastRoot_].firstChild[lastAction_]; c != kNone; c = nodes_[c].nextSibling) {
+                if (nodes_[c].key == key) {
+                    root = c;
+                    break;
+                }
+            }
+        }
+        if (root == kNone || nodes_.size() > kMaxNodes / 2) {
+            nodes_.clear();
+            root = newNode(key);
+        }
+        root_ = root;
+        rollouts_ = 0;
+    }
+
+    void search(const GameState& state, const Decision& decision, std::chrono::steady_clock::time_point deadline) {
+        do {
+            rollout(state, decision);
+        } while (std::chrono::steady_clock::now() < deadline);
+    }
+
+    void commit(int action) {
+        lastRoot_ = root_;
+        lastAction_ = action;
+    }
+
+    uint32_t rootCount(int action) const { return nodes_[root_].count[action]; }
+    long getRollouts() const { return rollouts_; }
+
+    // Rollout-time answers: opponents follow their model, the bot walks the
+    // tree while it can and falls back to its default policy off-tree.
+    bool decide(const Decision& d) override {
+        if (d.playerId != me_) return opponents_.decide(d);
+        if (!inTree_ || nodes_.size() >= kMaxNodes) return own_.decide(d);
+
+        int32_t child = options_.transpositions ? transposition(d) : childFor(d);
+        int action = select(child);
+        path_.push_back({child, action});
+        cur_ = child;
+        curAction_ = action;
+        return action == 1;
+    }
+
+private:
+    struct Node {
+        uint32_t key;
+        int32_t firstChild[2];  // next decision nodes after answering no / yes
+        int32_t nextSibling;
+        uint32_t visits;
+        uint32_t count[2];
+        double value[2];
+    };
+    struct Step {
+        int32_t node;
+        int action;
+    };
+
+    int32_t newNode(uint32_t key) {
+        nodes_.push_back(Node{key, {kNone, kNone}, kNone, 0, {0, 0}, {0.0, 0.0}});
+        return int32_t(nodes_.size() - 1);
+    }
+
+    // The node for this question below the current answer. Expansion: one
+    // new node per rollout, then leave the tree.
+    int32_t childFor(const Decision& d) {
+        uint32_t key = contextKey(d);
+        for (int32_t c = nodes_[cur_].firstChild[curAction_]; c != kNone; c = nodes_[c].nextSibling) {
+            if (nodes_[c].key == key) return c;
+        }
+        int32_t child = newNode(key);
+        nodes_[child].nextSibling = nodes_[cur_].firstChild[curAction_];
+        nodes_[cur_].firstChild[curAction_] = child;
+        inTree_ = false;
+        return child;
+    }
+
+    // The node for this question in the game's current state, however the
+    // search got there; expands the same way as childFor().
+    int32_t transposition(const Decision& d) {
+        auto [slot, added] = table_.try_emplace(stateKey(game_, d), int32_t(nodes_.size()));
+        if (added) {
+            newNode(contextKey(d));
+            inTree_ = false;
+        }
+        return slot->second;
+    }
+
+    // UCT; an untried answer is always tried first.
+    int select(int32_t n) const {
+        const Node& node = nodes_[n];
+        if (node.count[1] == 0) return 1;
+        if (node.count[0] == 0) return 0;
+        double logN = std::log(double(node.visits));
+        double best = -1;
+        int action = 1;
+        for (int a = 1; a >= 0; --a) {
+            double score = node.value[a] / node.count[a] + options_.exploration * std::sqrt(logN / node.count[a]);
+            if (score > best) {
+                best = score;
+                action = a;
+            }
+        }
+        return action;
+    }
+
+    void rollout(const GameState& state, const Decision& decision) {
+        game_.restore(state);
+        game_.reseedDice(options_.seed, streamBase_ + nextStream_++);
+
+        path_.clear();
+        int action = select(root_);
+        path_.push_back({root_, action});
+        cur_ = root_;
+        curAction_ = action;
+        inTree_ = true;
+
+        game_.resumeTurn(decision, action == 1);
+        long limit = game_.getTurnCount() + options_.horizon;
+        game_.runToCompletion(limit);
+
+        double reward = evaluate();
+        for (const Step& step : path_) {
+            Node& node = nodes_[step.node];
+            node.visits++;
+            node.count[step.action]++;
+            node.value[step.action] += reward;
+        }
+        rollouts_++;
+    }
+
+    // 1 for winning outright, 0 for going bankrupt, otherwise the bot's
+    // share of the net worth still on the table.
+    double evaluate() const {
+        if (game_.getStatus(me_) == PlayerStatus::Bankrupt) return 0.0;
+        if (game_.isOver()) return 1.0;
+        double mine = 0, total = 0;
+        for (int p = 0; p < game_.getPlayerCount(); ++p) {
+            if (game_.getStatus(p) == PlayerStatus::Bankrupt) continue;
+            double worth = worthOf(p);
+            total += worth;
+            if (p == me_) mine = worth;
+        }
+        return total > 0 ? mine / total : 0.0;
+    }
+
+    double worthOf(int p) const {
+        double worth = game_.getMoney(p) > 0 ? game_.getMoney(p) : 0;
+        for (int u = 0; u < board_.unitCount; ++u) {
+            if (game_.getOwner(u) != p) continue;
+            worth += board_.price[u];
+            if (board_.kind[u] == UnitKind::Upgradable) {
+                worth += double(game_.getLevel(u) - 1) * board_.upgradePrice[u];
+            }
+        }
+        return worth;
+    }
+
+    const BoardLayout& board_;
+    Options options_;
+    FastGame game_;
+    ThresholdPolicy opponents_;
+    ThresholdPolicy own_;
+
+    std::vector<Node> nodes_;
+    std::unordered_map<uint64_t, int32_t> table_;   // state hash -> node, with transpositions
+    std::vector<Step> path_;
+    int32_t root_ = kNone;
+    int32_t lastRoot_ = kNone;
+    int lastAction_ = 0;
+    int32_t cur_ = kNone;
+    int curAction_ = 0;
+    bool inTree_ = false;
+    int me_ = 0;
+
+    uint64_t streamBase_ = 0;
+    uint64_t nextStream_ = 0;
+    long rollouts_ = 0;
+};
+
+// ================== MCTS Policy ==================
+MctsPolicy::MctsPolicy(const BoardLayout& board, int numPlayers, const Options& options, StateSource source)
+    : options_(options), source_(std::move(source)) {
+    if (options_.threads < 1) options_.threads = 1;
+    for (int t = 0; t < options_.threads; ++t) {
+        searchers_.push_back(std::make_unique<Searcher>(board, numPlayers, options_, t + 1));
+    }
+}
+
+MctsPolicy::~MctsPolicy() = default;
+
+bool MctsPolicy::decide(const Decision& decision) {
+    GameState& state = state_;
+    decisions_++;
+    if (!source_ || !source_(state)) {
+        // No snapshot to search from: answer like the rollout policy would.
+        fallbacks_++;
+        return decision.money - decision.price >= options_.rolloutReserve;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + options_.budget;
+    for (auto& searcher : searchers_) {
+        searcher->beginDecision(state, decision);
+    }
+
+    // Root parallelism: every thread searches its own tree.
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < searchers_.size(); ++t) {
+        threads.emplace_back([&, t] { searchers_[t]->search(state, decision, deadline); });
+    }
+    searchers_[0]->search(state, decision, deadline);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    uint64_t visits[2] = {0, 0};
+    long rollouts = 0;
+    for (auto& searcher : searchers_) {
+        visits[0] += searcher->rootCount(0);
+        visits[1] += searcher->rootCount(1);
+        rollouts += searcher->getRollouts();
+    }
+    int action = visits[1] >= visits[0] ? 1 : 0;
+    for (auto& searcher : searchers_) {
+        searcher->commit(action);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    lastRollouts_ = rollouts;
+    lastRate_ = seconds > 0 ? rollouts / seconds : 0;
+    totalRollouts_ += rollouts;
+    totalSeconds_ += seconds;
+    return action == 1;
+}
@@ -0,0 +1,81 @@
+#ifndef MCTS__
+#define MCTS__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "fast_game.h"
+#include "game_state.h"
+#include "policy.h"
+
+// ================== MCTS Policy ==================
+// Bot that answers buy/upgrade questions with Monte Carlo Tree Search.
+//
+// At every decision it snapshots the live game (through the state source),
+// then several threads each grow their own search tree by playing rollouts
+// on a private FastGame until the time budget runs out; the root statistics
+// of all threads are summed and the most visited answer wins (root
+// parallelism). Dice are chance events, so the tree is open-loop: a node is
+// "the bot's next decision of this kind on this unit" after a given
+// sequence of its own answers, and every rollout draws fresh dice.
+//
+// Trees are kept between decisions: after answering, each thread's root
+// moves to the subtree of the chosen answer, and the next real decision
+// continues from the matching child if the search had already reached it.
+//
+// With transpositions on, a node is instead the decision in one exact
+// state: nodes live in a transposition table keyed by the game's Zobrist
+// hash (money bucketed, see zobrist.h) and the question, so every path
+// that reaches the same state shares its statistics, and the next real
+// decision finds its node by state however it was reached.
+class MctsPolicy : public DecisionPolicy {
+public:
+    struct Options {
+        std::chrono::microseconds budget{10000}; // per decision
+        int threads = 1;
+        int horizon = 200;          // rollout length in turns
+        double exploration = 1.0;   // UCT constant
+        int opponentReserve = 0;    // opponents are modelled as ThresholdPolicy
+        int rolloutReserve = 0;     // the bot's own default policy off-tree
+        bool transpositions = false;
+        uint64_t seed = 1;
+    };
+
+    // The state source must fill in the live game as seen during the visit
+    // (the deciding player still current). Game::save and FastGame::save
+    // both do that when called from inside a decision. A decision the
+    // source cannot snapshot is answered by the rollout policy's threshold
+    // rule instead of a search, and counted in getFallbacks().
+    using StateSource = std::function<bool(GameState&)>;
+
+    MctsPolicy(const BoardLayout& board, int numPlayers, const Options& options, StateSource source);
+    ~MctsPolicy();
+
+    bool decide(const Decision& decision) override;
+
+    long getLastRollouts() const { return lastRollouts_; }
+    double getLastRolloutsPerSecond() const { return lastRate_; }
+    long getTotalRollouts() const { return totalRollouts_; }
+    double getTotalSearchSeconds() const { return totalSeconds_; }
+    long getDecisions() const { return decisions_; }
+    long getFallbacks() const { return fallbacks_; }
+
+private:
+    class Searcher;
+
+    Options options_;
+    StateSource source_;
+    GameState state_;   // the live game at the current decision, reused
+    std::vector<std::unique_ptr<Searcher>> searchers_;
+    long lastRollouts_ = 0;
+    double lastRate_ = 0;
+    long totalRollouts_ = 0;
+    double totalSeconds_ = 0;
+    long decisions_ = 0;
+    long fallbacks_ = 0;
+};
+
+#endif
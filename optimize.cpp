@@ -0,0 +1,370 @@
+// Tunes a bot's buy/upgrade strategy for one board by playing headless
+// games across all cores.
+//
+//   optimize [-p players] [-t threads] [-s seed] [-m map.dat]
+//            [--generations N] [--population L] [--games G]
+//            [--max-turns N] [--opponent-reserve R] [--checkpoint file]
+//            [--stall-repeats N]
+//
+// The search is an evolution strategy over the numbers of a Strategy:
+// every generation samples L candidates around the current mean, plays G
+// games with each (the candidate in one seat, ThresholdPolicy bots with
+// --opponent-reserve in the others) and moves the mean towards the ones
+// that won most: an isotropic (mu/mu_w, lambda)-ES. Only the one step size
+// sigma adapts, by cumulative step-size adaptation (path length control);
+// every dimension is sampled with the same variance, which the scaling of
+// the genome makes good enough for ten numbers.
+//
+// The candidate's seat rotates from game to game, and all candidates of a
+// generation play the same dice, so a difference in win rate is the
+// strategy and not the luck of the draw. The mean itself is played too:
+// its win rate is the figure to watch.
+//
+// Candidates that stop buying make games that can only end at the turn
+// cap. --stall-repeats N calls a game for the richest player once its
+// state, positions aside, has started N rounds; off (0) by default. The
+// state counts money in 1000s and saturates at 256k, so once everyone is
+// that rich only ownership, levels and statuses tell rounds apart: N
+// then cuts games that are still changing hands in cash, not just true
+// repeats, and shifts win rates (on map.dat with 4 seats, 16 ends 95% of
+// games at about a quarter of their played-out length).
+//
+// --checkpoint writes the search state after every generation (to a
+// temporary file renamed over the old one) and resumes from it when it
+// already exists; --generations is then the total to reach.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fast_game.h"
+#include "map.h"
+#include "map_image.h"
+#include "policy.h"
+#include "rng.h"
+#include "scheduler.h"
+
+namespace {
+
+// Genome layout: one switch and one reserve per purchasable kind, then one
+// reserve per upgrade level. Reserves are in units of kCashScale.
+const int kDims = 2 * Strategy::kBuyKinds + 4;
+const double kCashScale = 5000;
+// Games per scheduler item: enough to amortize the handoff, few enough
+// that the last items of a generation spread over all workers.
+const long kGamesPerBlock = 16;
+
+Strategy toStrategy(const std::vector<double>& x) {
+    Strategy strategy;
+    int i = 0;
+    for (int k = 0; k < Strategy::kBuyKinds; ++k) strategy.buy[k] = x[i++] > 0;
+    for (int k = 0; k < Strategy::kBuyKinds; ++k) {
+        strategy.buyReserve[k] = int(std::lround(std::max(0.0, x[i++]) * kCashScale));
+    }
+    for (int& reserve : strategy.upgradeReserve) {
+        reserve = int(std::lround(std::max(0.0, x[i++]) * kCashScale));
+    }
+    return strategy;
+}
+
+// Standard normal deviates from the counter-based Rng (Box-Muller), so a
+// seed gives the same search everywhere.
+double gaussian(Rng& rng) {
+    double u1 = (rng.next() + 1.0) / 4294967297.0;
+    double u2 = rng.next() / 4294967296.0;
+    return std::sqrt(-2 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+// Everything the search needs to continue where it stopped.
+struct SearchState {
+    static constexpr const char* kMagic = "optimize-checkpoint";
+    static constexpr int kVersion = 1;
+
+    uint32_t boardFingerprint = 0;
+    int numPlayers = 0;
+    int generation = 0;
+    double sigma = 1;
+    std::vector<double> mean = std::vector<double>(kDims, 0);
+    std::vector<double> path = std::vector<double>(kDims, 0);
+    long games = 0;
+    double bestRate = -1;   // of the mean, over all generations
+    std::vector<double> best = std::vector<double>(kDims, 0);
+};
+
+bool writeCheckpoint(const std::string& path, const SearchState& state) {
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << std::setprecision(17);
+        out << SearchState::kMagic << " " << SearchState::kVersion << "\n";
+        out << "board " << state.boardFingerprint << "\n";
+        out << "players " << state.numPlayers << "\n";
+        out << "generation " << state.generation << "\n";
+        out << "games " << state.games << "\n";
+        out << "sigma " << state.sigma << "\n";
+        out << "best-rate " << state.bestRate << "\n";
+        for (auto [name, values] : {std::pair{"mean", &state.mean}, std::pair{"path", &state.path},
+                                    std::pair{"best", &state.best}}) {
+            out << name;
+            for (double v : *values) out << " " << v;
+            out << "\n";
+        }
+        if (!out.flush()) return false;
+    }
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool readCheckpoint(const std::string& path, SearchState& state, std::string& error) {
+    std::ifstream in(path);
+    std::string magic, name;
+    int version = 0;
+    if (!(in >> magic >> version) || magic != SearchState::kMagic || version != SearchState::kVersion) {
+        error = "not an optimize checkpoint";
+        return false;
+    }
+    SearchState loaded;
+    in >> name >> loaded.boardFingerprint >> name >> loaded.numPlayers
+       >> name >> loaded.generation >> name >> loaded.games
+       >> name >> loaded.sigma >> name >> loaded.bestRate;
+    for (std::vector<double>* values : {&loaded.mean, &loaded.path, &loaded.best}) {
+        in >> name;
+        for (double& v : *values) in >> v;
+    }
+    if (!in) {
+        error = "truncated checkpoint";
+        return false;
+    }
+    state = loaded;
+    return true;
+}
+
+// One worker thread's engine, seats and tallies; nothing is shared.
+struct alignas(64) Worker {
+    Worker(const BoardLayout& layout, int numPlayers, int opponentReserve, int stallRepeats)
+        : game(layout, numPlayers), candidate(layout.kind), opponent(opponentReserve) {
+        game.setStallLimit(stallRepeats);
+    }
+
+    // Plays games first .. first + count - 1 of a generation with
+    // `strategy` and counts its wins in wins[slot].
+    void play(const Strategy& strategy, int slot, uint64_t seed, long first, long count, long maxTurns) {
+        candidate.setStrategy(strategy);
+        const int numPlayers = game.getPlayerCount();
+        for (long g = first; g < first + count; ++g) {
+            int seat = int(g % numPlayers);
+            for (int i = 0; i < numPlayers; ++i) {
+                game.setPolicy(i, i == seat ? static_cast<DecisionPolicy*>(&candidate) : &opponent);
+            }
+            game.reset(seed, g);
+            if (game.runToCompletion(maxTurns) == seat) wins[slot]++;
+            games++;
+        }
+    }
+
+    FastGame game;
+    StrategyPolicy candidate;
+    ThresholdPolicy opponent;
+    std::vector<long> wins;
+    long games = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int numPlayers = 4;
+    int numThreads = std::thread::hardware_concurrency();
+    uint64_t seed = 1;
+    std::string mapPath = "map.dat";
+    int generations = 30;
+    int population = 16;
+    long gamesPerCandidate = 2000;
+    long maxTurns = 10000;
+    int opponentReserve = 0;
+    std::string checkpointPath;
+    int stallRepeats = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-p" && hasValue) numPlayers = std::atoi(argv[++i]);
+        else if (arg == "-t" && hasValue) numThreads = std::atoi(argv[++i]);
+        else if (arg == "-s" && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-m" && hasValue) mapPath = argv[++i];
+        else if (arg == "--generations" && hasValue) generations = std::atoi(argv[++i]);
+        else if (arg == "--population" && hasValue) population = std::atoi(argv[++i]);
+        else if (arg == "--games" && hasValue) gamesPerCandidate = std::atol(argv[++i]);
+        else if (arg == "--max-turns" && hasValue) maxTurns = std::atol(argv[++i]);
+        else if (arg == "--opponent-reserve" && hasValue) opponentReserve = std::atoi(argv[++i]);
+        else if (arg == "--checkpoint" && hasValue) checkpointPath = argv[++i];
+        else if (arg == "--stall-repeats" && hasValue) stallRepeats = std::atoi(argv[++i]);
+        else {
+            std::cerr << "usage: optimize [-p players] [-t threads] [-s seed] [-m map.dat]"
+                         " [--generations N] [--population L] [--games G]"
+                         " [--max-turns N] [--opponent-reserve R] [--checkpoint file]"
+                         " [--stall-repeats N]\n";
+            return 1;
+        }
+    }
+    if (numPlayers < 2) {
+        std::cerr << "optimize needs at least 2 players\n";
+        return 1;
+    }
+    if (numThreads < 1) numThreads = 1;
+    if (population < 4) population = 4;
+    if (gamesPerCandidate < 1) gamesPerCandidate = 1;
+
+    // Prefer a compiled image; fall back to parsing map.dat text.
+    MapImage image;
+    std::string imageError;
+    std::vector<UnitSpec> specs;
+    std::unique_ptr<BoardLayout> layout;
+    if (image.open(mapPath, imageError)) {
+        specs = image.toSpecs();
+        layout = std::make_unique<BoardLayout>(image);
+    } else {
+        std::vector<std::string> errors;
+        parseMapFile(mapPath, specs, errors);
+        for (const auto& error : errors) std::cerr << error << "\n";
+        layout = std::make_unique<BoardLayout>(specs);
+    }
+    if (specs.empty()) {
+        std::cerr << mapPath << ": no units\n";
+        return 1;
+    }
+
+    // Start from buying everything with no reserve: the ThresholdPolicy(0)
+    // bot every other tool seats.
+    SearchState state;
+    state.boardFingerprint = layout->fingerprint();
+    state.numPlayers = numPlayers;
+    for (int k = 0; k < Strategy::kBuyKinds; ++k) state.mean[k] = 1;
+    if (!checkpointPath.empty() && std::ifstream(checkpointPath)) {
+        std::string error;
+        SearchState loaded;
+        if (!readCheckpoint(checkpointPath, loaded, error)) {
+            std::cerr << checkpointPath << ": " << error << "\n";
+            return 1;
+        }
+        if (loaded.boardFingerprint != state.boardFingerprint || loaded.numPlayers != numPlayers) {
+            std::cerr << checkpointPath << ": saved for another board or player count\n";
+            return 1;
+        }
+        state = loaded;
+        std::cout << "resuming at generation " << state.generation << "\n";
+    }
+
+    // Recombination weights and step-size constants of CMA-ES.
+    const int parents = population / 2;
+    std::vector<double> weights(parents);
+    for (int i = 0; i < parents; ++i) weights[i] = std::log(parents + 0.5) - std::log(i + 1.0);
+    double weightSum = std::accumulate(weights.begin(), weights.end(), 0.0);
+    double muEff = 0;
+    for (double& w : weights) {
+        w /= weightSum;
+        muEff += w * w;
+    }
+    muEff = 1 / muEff;
+    const double n = kDims;
+    const double cSigma = (muEff + 2) / (n + muEff + 5);
+    const double dSigma = 1 + 2 * std::max(0.0, std::sqrt((muEff - 1) / (n + 1)) - 1) + cSigma;
+    const double expectedNorm = std::sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int w = 0; w < numThreads; ++w) {
+        workers.push_back(std::make_unique<Worker>(*layout, numPlayers, opponentReserve, stallRepeats));
+    }
+    WorkStealingScheduler scheduler(numThreads);
+
+    const int candidates = population + 1;   // the last one is the mean
+    const long blocks = (gamesPerCandidate + kGamesPerBlock - 1) / kGamesPerBlock;
+    std::vector<std::vector<double>> z(population, std::vector<double>(kDims));
+    std::vector<Strategy> strategies(candidates);
+    std::vector<long> wins(candidates);
+    std::vector<int> order(population);
+
+    while (state.generation < generations) {
+        // Sample around the mean. The generation picks both the mutations
+        // and the dice, so a resumed search takes the same steps.
+        Rng sampler(~seed, state.generation);
+        for (int k = 0; k < population; ++k) {
+            std::vector<double> x(kDims);
+            for (int d = 0; d < kDims; ++d) {
+                z[k][d] = gaussian(sampler);
+                x[d] = state.mean[d] + state.sigma * z[k][d];
+            }
+            strategies[k] = toStrategy(x);
+        }
+        strategies[population] = toStrategy(state.mean);
+
+        for (auto& worker : workers) worker->wins.assign(candidates, 0);
+        const uint64_t diceSeed = seed + 1 + state.generation;
+        auto start = std::chrono::steady_clock::now();
+        scheduler.run(candidates * blocks, [&](int w, long item) {
+            int slot = int(item / blocks);
+            long first = (item % blocks) * kGamesPerBlock;
+            long count = std::min(kGamesPerBlock, gamesPerCandidate - first);
+            workers[w]->play(strategies[slot], slot, diceSeed, first, count, maxTurns);
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::fill(wins.begin(), wins.end(), 0);
+        for (const auto& worker : workers) {
+            for (int c = 0; c < candidates; ++c) wins[c] += worker->wins[c];
+        }
+        state.games += candidates * gamesPerCandidate;
+
+        // The mean that was played is the one before the update.
+        double meanRate = double(wins[population]) / gamesPerCandidate;
+        if (meanRate > state.bestRate) {
+            state.bestRate = meanRate;
+            state.best = state.mean;
+        }
+
+        // Move the mean towards the winners and adapt the step size.
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return wins[a] > wins[b]; });
+        std::vector<double> zMean(kDims, 0);
+        for (int i = 0; i < parents; ++i) {
+            for (int d = 0; d < kDims; ++d) zMean[d] += weights[i] * z[order[i]][d];
+        }
+        const double pathScale = std::sqrt(cSigma * (2 - cSigma) * muEff);
+        double pathNorm = 0;
+        for (int d = 0; d < kDims; ++d) {
+            state.mean[d] += state.sigma * zMean[d];
+            state.path[d] = (1 - cSigma) * state.path[d] + pathScale * zMean[d];
+            pathNorm += state.path[d] * state.path[d];
+        }
+        state.sigma *= std::exp(cSigma / dSigma * (std::sqrt(pathNorm) / expectedNorm - 1));
+
+        ++state.generation;
+
+        std::cout << "gen " << std::setw(3) << state.generation
+                  << std::fixed << std::setprecision(2)
+                  << "  mean wins " << 100.0 * meanRate << "%"
+                  << "  best candidate " << 100.0 * wins[order[0]] / gamesPerCandidate << "%"
+                  << "  sigma " << std::setprecision(3) << state.sigma
+                  << "  games/sec " << std::setprecision(0) << candidates * gamesPerCandidate / seconds
+                  << "\n    " << strategies[population].toString() << "\n" << std::flush;
+
+        if (!checkpointPath.empty() && !writeCheckpoint(checkpointPath, state)) {
+            std::cerr << checkpointPath << ": cannot write checkpoint\n";
+            return 1;
+        }
+    }
+
+    std::cout << "games " << state.games << "  fair share " << std::setprecision(2)
+              << 100.0 / numPlayers << "%\n";
+    std::cout << "best mean " << std::setprecision(2) << 100.0 * std::max(0.0, state.bestRate) << "%  "
+              << toStrategy(state.best).toString() << "\n";
+    return 0;
+}
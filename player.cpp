@@ -1,5 +1,8 @@
 #include "player.h"
 #include "map.h" // Include map.h to get full definition of MapUnit
+#include "game_state.h"
+#include "instrument.h"
+#include <algorithm>
 
 
 // ================== Player ==================
@@ -14,16 +17,16 @@ const int Player::getUnitCount() const { return owned_units_.size(); }
 
 // Gets the count of only 'Collectable' type units, needed for fine calculation
 const int Player::getNumCollectableUnits() const {
-    int count = 0;
-    for (const auto& unit : owned_units_) {
-        if (unit->type() == "C") {
-            count++;
-        }
-    }
-    return count;
+    return getNumUnits(UnitKind::Collectable);
+}
+
+bool Player::ownsUnit(int unitId) const {
+    size_t word = unitId / 64;
+    return word < ownedBits_.size() && (ownedBits_[word] >> (unitId % 64) & 1);
 }
 
 int Player::pay(int amount) {
+    INSTRUMENT_COUNT(Pay, amount);
     int payment = amount;
     if (money_ < amount) {
         payment = money_;
@@ -33,10 +36,12 @@ int Player::pay(int amount) {
 }
 
 void Player::receive(int amount) {
+    INSTRUMENT_COUNT(Receive, amount);
     money_ += amount;
 }
 
 void Player::moveTo(int new_location, WorldMap* map) {
+    INSTRUMENT_SCOPE(Move);
     // Remove player from the old location's list
     if(map->getUnit(location_)) {
         map->getUnit(location_)->removePlayerHere(this);
@@ -50,14 +55,24 @@ void Player::moveTo(int new_location, WorldMap* map) {
 
 void Player::addUnit(MapUnit* unit) {
     owned_units_.push_back(unit);
+    kindCounts_[static_cast<int>(unit->kind())]++;
+    size_t word = unit->getId() / 64;
+    if (word >= ownedBits_.size()) {
+        ownedBits_.resize(word + 1, 0);
+    }
+    ownedBits_[word] |= uint64_t(1) << (unit->getId() % 64);
 }
 
 // When a player goes bankrupt, release all their properties
 void Player::releaseAllUnits() {
     for (auto& unit : owned_units_) {
         unit->reset(); // Reset unit to default state (no owner, level 1, etc.)
+        ownedBits_[unit->getId() / 64] &= ~(uint64_t(1) << (unit->getId() % 64));
     }
     owned_units_.clear();
+    for (int& count : kindCounts_) {
+        count = 0;
+    }
 }
 
 void Player::setToJail() {
@@ -69,10 +84,29 @@ void Player::releaseFromJail() {
 }
 
 void Player::declareBankruptcy() {
+    INSTRUMENT_COUNT(Bankruptcy, 1);
     status_ = PlayerStatus::Bankrupt;
     Player::releaseAllUnits();
 }
 
+void Player::reset() {
+    location_ = 0;
+    money_ = 30000;
+    owned_units_.clear();
+    for (int& count : kindCounts_) {
+        count = 0;
+    }
+    std::fill(ownedBits_.begin(), ownedBits_.end(), 0);
+    status_ = PlayerStatus::Normal;
+}
+
+void Player::restore(int money, int location, PlayerStatus status) {
+    reset();
+    money_ = money;
+    location_ = location;
+    status_ = status;
+}
+
 // ================== World Player ==================
 WorldPlayer::WorldPlayer(int num_player, std::vector<std::string>& Names){
     for(int i = 0; i < num_player; ++i) {
@@ -85,6 +119,34 @@ WorldPlayer::~WorldPlayer(){
     }
 }
 
+void WorldPlayer::reset() {
+    for (auto player : players_) {
+        player->reset();
+    }
+}
+
+bool WorldPlayer::save(GameState& state) const {
+    if (players_.size() > size_t(kMaxStatePlayers)) return false;
+    state.playerCount = players_.size();
+    state.players.resize(players_.size());
+    for (size_t i = 0; i < players_.size(); ++i) {
+        PlayerSnapshot& snap = state.players[i];
+        snap.money = players_[i]->getMoney();
+        snap.location = players_[i]->getLocation();
+        snap.status = static_cast<uint8_t>(players_[i]->getStatus());
+    }
+    return true;
+}
+
+bool WorldPlayer::restore(const GameState& state) {
+    if (state.playerCount != players_.size()) return false;
+    for (size_t i = 0; i < players_.size(); ++i) {
+        const PlayerSnapshot& snap = state.players[i];
+        players_[i]->restore(snap.money, snap.location, static_cast<PlayerStatus>(snap.status));
+    }
+    return true;
+}
+
 Player* WorldPlayer::playerNow(int index) const {
     return (index >= 0 && index < players_.size()) ? players_[index] : nullptr;
 }
@@ -1,13 +1,16 @@
 #ifndef PLAYER__
 #define PLAYER__
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
 
-// Forward declare MapUnit & WorldMap class
+#include "map.h" // For UnitKind
+
 class MapUnit;
 class WorldMap;
+struct GameState;
 
 enum class PlayerStatus { Normal, InJail, Bankrupt };
 
@@ -24,6 +27,8 @@ public:
     const PlayerStatus getStatus() const;
     const int getUnitCount() const;
     const int getNumCollectableUnits() const;
+    const int getNumUnits(UnitKind kind) const { return kindCounts_[static_cast<int>(kind)]; }
+    bool ownsUnit(int unitId) const;
 
 
     //void pay(Player* player, int amount);
@@ -35,6 +40,11 @@ public:
     void setToJail();
     void releaseFromJail();
     void declareBankruptcy();
+    // Back to the starting money and location, owning nothing.
+    void reset();
+    // Owning nothing, with the given money, location and status (used when
+    // restoring a snapshot; WorldMap::restore hands the units back).
+    void restore(int money, int location, PlayerStatus status);
 
 private:
     int id_ = 0;
@@ -42,6 +52,10 @@ private:
     int location_ = 0;
     int money_ = 30000;
     std::vector<MapUnit*> owned_units_;
+    // Ownership index kept in step with owned_units_ by addUnit and
+    // releaseAllUnits: units owned per kind, and one bit per unit id.
+    int kindCounts_[kNumUnitKinds] = {0};
+    std::vector<uint64_t> ownedBits_;
     PlayerStatus status_ = PlayerStatus::Normal; // Normal, InJail, Bankruptcy
 };
 
@@ -51,6 +65,9 @@ public:
   WorldPlayer(int num_player, std::vector<std::string>& Names);
   ~WorldPlayer();
 
+  void reset();
+  bool save(GameState& state) const;
+  bool restore(const GameState& state);
   Player* playerNow(int index) const;
   const int getPlayerCount() const;
 private:
@@ -0,0 +1,66 @@
+#include "policy.h"
+#include "map.h"
+#include "player.h"
+#include "instrument.h"
+#include <iostream>
+
+
+// ================== Console Policy ==================
+ConsolePolicy::ConsolePolicy(const WorldMap& map, const WorldPlayer& players)
+    : map_(map), players_(players) {}
+
+bool ConsolePolicy::decide(const Decision& decision) {
+    const Player* player = players_.playerNow(decision.playerId);
+    const MapUnit* unit = map_.getUnit(decision.unitId);
+
+    if (decision.kind == DecisionKind::Buy) {
+        std::cout << player->getName() << ", do you want to buy " << unit->getName() << "? (1: Yes [default] / 2: No) ...>";
+    } else {
+        std::cout << player->getName() << ", do you want to upgrade " << unit->getName() << "? (1: Yes [default] / 2: No)...>";
+    }
+    std::string choice = "";
+    {
+        INSTRUMENT_SCOPE(InputWait);
+        std::getline(std::cin, choice);
+    }
+    return choice != "2";
+}
+
+// ================== Scripted Policy ==================
+bool ScriptedPolicy::decide(const Decision& /*decision*/) {
+    if (answers_.empty()) return false;
+    bool accept = answers_.front();
+    answers_.pop_front();
+    return accept;
+}
+
+// ================== Threshold Policy ==================
+bool ThresholdPolicy::decide(const Decision& decision) {
+    return decision.money - decision.price >= reserve_;
+}
+
+// ================== Strategy Policy ==================
+std::string Strategy::toString() const {
+    static const char kLetters[kBuyKinds] = {'U', 'C', 'R'};
+    std::string text = "buy";
+    for (int k = 0; k < kBuyKinds; ++k) {
+        text += ' ';
+        text += buy[k] ? kLetters[k] : '-';
+    }
+    text += "  reserve";
+    for (int k = 0; k < kBuyKinds; ++k) text += " " + std::to_string(buyReserve[k]);
+    text += "  upgrade";
+    for (int reserve : upgradeReserve) text += " " + std::to_string(reserve);
+    return text;
+}
+
+bool StrategyPolicy::decide(const Decision& decision) {
+    int left = decision.money - decision.price;
+    if (decision.kind == DecisionKind::Upgrade) {
+        // decision.level is the level before the upgrade, 1..4.
+        return left >= strategy_.upgradeReserve[decision.level - 1];
+    }
+    int kind = static_cast<int>(kinds_[decision.unitId]);
+    if (kind >= Strategy::kBuyKinds || !strategy_.buy[kind]) return false;
+    return left >= strategy_.buyReserve[kind];
+}
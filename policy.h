@@ -0,0 +1,99 @@
+#ifndef POLICY__
+#define POLICY__
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+class WorldMap;
+class WorldPlayer;
+enum class UnitKind : uint8_t;
+
+// ================== Decision ==================
+// Everything a policy needs to answer a yes/no question during a visit.
+// Kept as plain values so the same policy can drive any engine.
+enum class DecisionKind { Buy, Upgrade };
+
+struct Decision {
+    DecisionKind kind = DecisionKind::Buy;
+    int playerId = 0;
+    int unitId = 0;
+    int money = 0;   // cash of the deciding player before paying
+    int price = 0;   // what accepting costs
+    int level = 1;   // current level of the unit (1 for purchases)
+};
+
+// ================== Decision Policy ==================
+class DecisionPolicy {
+public:
+    virtual ~DecisionPolicy() = default;
+
+    // Returns true to accept the offer (buy or upgrade).
+    virtual bool decide(const Decision& decision) = 0;
+};
+
+// Asks the human at the terminal, exactly like the original prompts.
+class ConsolePolicy : public DecisionPolicy {
+public:
+    ConsolePolicy(const WorldMap& map, const WorldPlayer& players);
+    bool decide(const Decision& decision) override;
+private:
+    const WorldMap& map_;
+    const WorldPlayer& players_;
+};
+
+// Bot that accepts every offer which leaves at least `reserve` in cash.
+// With reserve 0 it behaves like a human always pressing Enter.
+class ThresholdPolicy : public DecisionPolicy {
+public:
+    explicit ThresholdPolicy(int reserve = 0) : reserve_(reserve) {}
+    bool decide(const Decision& decision) override;
+private:
+    int reserve_ = 0;
+};
+
+// ================== Strategy ==================
+// A bot's buy/upgrade behaviour as a handful of numbers, which is what the
+// optimizer searches: per purchasable unit kind, whether to buy at all and
+// the cash to keep after buying; per level 2..5, the cash to keep after
+// upgrading to it. The default buys everything, like ThresholdPolicy(0).
+struct Strategy {
+    static constexpr int kBuyKinds = 3;   // Upgradable, Collectable, RandomCost
+
+    bool buy[kBuyKinds] = {true, true, true};
+    int buyReserve[kBuyKinds] = {0, 0, 0};
+    int upgradeReserve[4] = {0, 0, 0, 0};
+
+    // "buy U C R  reserve 0 0 0  upgrade 0 0 0 0", with "-" for a kind
+    // that is never bought.
+    std::string toString() const;
+};
+
+// Plays a Strategy. Purchases need the kind of the unit on offer, so the
+// policy keeps the board's kind table (e.g. BoardLayout::kind).
+class StrategyPolicy : public DecisionPolicy {
+public:
+    StrategyPolicy(const UnitKind* kinds, const Strategy& strategy = Strategy())
+        : kinds_(kinds), strategy_(strategy) {}
+    void setStrategy(const Strategy& strategy) { strategy_ = strategy; }
+    const Strategy& getStrategy() const { return strategy_; }
+    bool decide(const Decision& decision) override;
+private:
+    const UnitKind* kinds_;
+    Strategy strategy_;
+};
+
+// Answers from a queue filled by the caller, for frontends that learn the
+// answer before the engine asks (network tables, journal replay). An
+// empty queue declines.
+class ScriptedPolicy : public DecisionPolicy {
+public:
+    void push(bool accept) { answers_.push_back(accept); }
+    void clear() { answers_.clear(); }
+    size_t pending() const { return answers_.size(); }
+    bool decide(const Decision& decision) override;
+private:
+    std::deque<bool> answers_;
+};
+
+#endif
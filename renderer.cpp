@@ -0,0 +1,204 @@
+#include "renderer.h"
+#include "map.h"
+#include "player.h"
+#include "instrument.h"
+#include <algorithm>
+
+
+namespace {
+const int kCellWidth = 40;
+// Larger boards only show the occupied units.
+const int kMaxFullBoardUnits = 48;
+}
+
+// ================== Frame ==================
+void Frame::add(int row, int col, int width, std::string text) {
+    if (count == cells.size()) cells.emplace_back();
+    Cell& cell = cells[count++];
+    cell.row = row;
+    cell.col = col;
+    cell.width = width;
+    cell.text = std::move(text);
+}
+
+// ================== Terminal Renderer ==================
+void TerminalRenderer::draw(const WorldMap& map, const WorldPlayer& players, int currentPlayerIndex) {
+    capture(map, players, currentPlayerIndex, next_);
+    present(next_);
+}
+
+void TerminalRenderer::present(Frame& frame) {
+    INSTRUMENT_SCOPE(Render);
+    buf_.clear();
+    // A different number of cells means the layout moved: repaint all.
+    bool full = !valid_ || frame.count != prev_.count;
+    if (full) {
+        buf_ += "\x1b[H\x1b[2J";
+    }
+    for (size_t i = 0; i < frame.count; ++i) {
+        const Frame::Cell& cell = frame.cells[i];
+        if (full || cell.row != prev_.cells[i].row || cell.col != prev_.cells[i].col ||
+            cell.text != prev_.cells[i].text) {
+            emitCell(cell);
+        }
+    }
+    // Park the cursor under the frame and clear the previous turn's
+    // narration and prompts.
+    buf_ += "\x1b[" + std::to_string(frame.height + 1) + ";1H\x1b[J";
+
+    out_.write(buf_.data(), buf_.size());
+    out_.flush();
+
+    // Keep this frame for the next diff, recycling the old strings.
+    if (prev_.cells.size() < frame.count) prev_.cells.resize(frame.count);
+    for (size_t i = 0; i < frame.count; ++i) {
+        std::swap(prev_.cells[i], frame.cells[i]);
+    }
+    prev_.count = frame.count;
+    prev_.height = frame.height;
+    valid_ = true;
+}
+
+void TerminalRenderer::emitCell(const Frame::Cell& cell) {
+    buf_ += "\x1b[";
+    buf_ += std::to_string(cell.row);
+    buf_ += ';';
+    buf_ += std::to_string(cell.col);
+    buf_ += 'H';
+    buf_ += cell.text;
+    if (cell.width == 0) {
+        buf_ += "\x1b[K";
+    } else if (cell.width > 0 && cell.text.size() < size_t(cell.width)) {
+        buf_.append(cell.width - cell.text.size(), ' ');
+    }
+}
+
+// Same layout as the original full-screen display: unit 0 at the top,
+// units running down the left column and back up the right column, then a
+// blank line, one status line per active player and another blank line.
+void TerminalRenderer::capture(const WorldMap& map, const WorldPlayer& players, int currentPlayerIndex, Frame& frame) {
+    frame.clear();
+    int row = 1;
+
+    const int map_size = map.getUnitCount();
+    if (map_size > kMaxFullBoardUnits) {
+        // Two units per row. There is a slot for every player whether or
+        // not they share a unit, so the frame keeps its shape and only the
+        // cells that changed are redrawn.
+        frame.occupied.clear();
+        for (int i = 0; i < players.getPlayerCount(); ++i) {
+            frame.occupied.push_back(players.playerNow(i)->getLocation());
+        }
+        std::sort(frame.occupied.begin(), frame.occupied.end());
+        frame.occupied.erase(std::unique(frame.occupied.begin(), frame.occupied.end()), frame.occupied.end());
+        int slot = 0;
+        for (int location : frame.occupied) {
+            const MapUnit* unit = map.getUnit(location);
+            if (!unit || unit->getPlayerCountHere() == 0) continue;
+            frame.add(row + slot / 2, 1 + (slot % 2) * kCellWidth, kCellWidth, unit->display());
+            ++slot;
+        }
+        for (; slot < players.getPlayerCount(); ++slot) {
+            frame.add(row + slot / 2, 1 + (slot % 2) * kCellWidth, kCellWidth, "");
+        }
+        row += (players.getPlayerCount() + 1) / 2;
+    }
+    else if (map_size > 0) {
+        int half_size = (map_size + 1) / 2;
+        frame.add(row, 1, kCellWidth, map.getUnit(0)->display());
+        if (map_size % 2 == 0) {
+            frame.add(row, 1 + kCellWidth, kCellWidth, map.getUnit(map_size - 1)->display());
+        }
+        ++row;
+        for (int i = 1; i < half_size; ++i, ++row) {
+            frame.add(row, 1, kCellWidth, map.getUnit(i)->display());
+            frame.add(row, 1 + kCellWidth, kCellWidth, map.getUnit(map_size - 1 - i)->display());
+        }
+    }
+
+    ++row; // blank line above the status block
+    for (int i = 0; i < players.getPlayerCount(); ++i) {
+        const Player* p = players.playerNow(i);
+        if (p->getStatus() == PlayerStatus::Bankrupt) {
+            continue;
+        }
+        // "=>[id]  <name right-aligned in 15>  $<money left-aligned in 7>with N units"
+        std::string line = (i == currentPlayerIndex) ? "=>" : "  ";
+        line += "[" + std::to_string(p->getId()) + "]  ";
+        std::string name = p->getName().substr(0, 15);
+        line.append(15 - name.size(), ' ');
+        line += name;
+        std::string money = std::to_string(p->getMoney());
+        line += "  $" + money;
+        if (money.size() < 7) line.append(7 - money.size(), ' ');
+        line += "with " + std::to_string(p->getUnitCount()) + " units";
+        frame.add(row++, 1, 0, std::move(line));
+    }
+    frame.height = row; // includes the blank line below the status block
+}
+
+// ================== Render Thread ==================
+RenderThread::RenderThread(std::ostream& out) : renderer_(out) {
+    thread_ = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void RenderThread::publish(const WorldMap& map, const WorldPlayer& players, int currentPlayerIndex) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_) ++dropped_;
+        TerminalRenderer::capture(map, players, currentPlayerIndex, *back_);
+        pending_ = true;
+        ++published_;
+    }
+    wake_.notify_one();
+}
+
+void RenderThread::sync() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    shown_.wait(lock, [&] { return drawn_ == published_; });
+}
+
+void RenderThread::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    invalidate_ = true;
+}
+
+uint64_t RenderThread::getPublished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return published_;
+}
+
+uint64_t RenderThread::getDropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void RenderThread::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [&] { return pending_ || stop_; });
+        if (!pending_) break;
+        std::swap(front_, back_);
+        pending_ = false;
+        uint64_t frame = published_;
+        bool full = invalidate_;
+        invalidate_ = false;
+
+        lock.unlock();
+        if (full) renderer_.invalidate();
+        renderer_.present(*front_);
+        lock.lock();
+
+        drawn_ = frame;
+        shown_.notify_all();
+    }
+}
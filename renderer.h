@@ -0,0 +1,116 @@
+#ifndef RENDERER__
+#define RENDERER__
+
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class WorldMap;
+class WorldPlayer;
+
+// ================== Frame ==================
+// One screen as positioned text cells, captured from the game state. Once
+// captured it no longer refers to the board or the players, so it can be
+// drawn later and on another thread.
+struct Frame {
+    struct Cell {
+        int row = 0;
+        int col = 0;
+        int width = 0;   // pad to this width; 0 means clear to end of line
+        std::string text;
+    };
+
+    void clear() { count = 0; }
+    void add(int row, int col, int width, std::string text);
+
+    std::vector<Cell> cells;   // only the first count are in use
+    size_t count = 0;
+    int height = 0;
+    std::vector<int> occupied; // scratch for the large-board layout
+};
+
+// ================== Terminal Renderer ==================
+// Draws the board and the player status with ANSI escape codes. It keeps
+// the previous frame and, on every draw, only rewrites the cells whose text
+// changed (usually the two cells a player moved between and one status
+// line), then wipes whatever narration was printed below the frame. All of
+// it goes out in a single write.
+//
+// A board too long for a screen is shown as just the units somebody stands
+// on, in board order, so a frame costs O(players) whatever the board size.
+class TerminalRenderer {
+public:
+    explicit TerminalRenderer(std::ostream& out = std::cout) : out_(out) {}
+
+    void draw(const WorldMap& map, const WorldPlayer& players, int currentPlayerIndex);
+
+    // draw() in two steps: capture() only reads the game, present() only
+    // writes the terminal. present() takes over the frame's strings, so the
+    // frame is only good for capturing into again afterwards.
+    static void capture(const WorldMap& map, const WorldPlayer& players, int currentPlayerIndex, Frame& frame);
+    void present(Frame& frame);
+
+    // Forces the next draw to repaint the whole screen, e.g. after other
+    // output scrolled the terminal.
+    void invalidate() { valid_ = false; }
+
+private:
+    void emitCell(const Frame::Cell& cell);
+
+    std::ostream& out_;
+    Frame prev_;
+    Frame next_;
+    bool valid_ = false;
+    std::string buf_;
+};
+
+// ================== Render Thread ==================
+// Draws frames on its own thread so the game never waits on the terminal.
+// The game thread captures into the back buffer and the render thread
+// swaps it to the front and draws it; publishing a frame before the last
+// one was picked up replaces it, so a slow terminal skips frames instead
+// of slowing the game down.
+//
+// Whoever else writes to the same terminal calls sync() first: it returns
+// once the last published frame is on screen and the render thread is idle.
+class RenderThread {
+public:
+    explicit RenderThread(std::ostream& out = std::cout);
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+    // Draws a pending frame, then joins the thread.
+    ~RenderThread();
+
+    // Captures the game as it is now. Never waits for the terminal.
+    void publish(const WorldMap& map, const WorldPlayer& players, int currentPlayerIndex);
+    void sync();
+    // The next frame repaints the whole screen.
+    void invalidate();
+
+    uint64_t getPublished() const;
+    uint64_t getDropped() const;
+
+private:
+    void run();
+
+    TerminalRenderer renderer_;
+    Frame buffers_[2];
+    Frame* front_ = &buffers_[0];   // render thread only, while drawing
+    Frame* back_ = &buffers_[1];    // under mutex_
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable shown_;
+    uint64_t published_ = 0;
+    uint64_t drawn_ = 0;
+    uint64_t dropped_ = 0;
+    bool pending_ = false;
+    bool invalidate_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,118 @@
+// Re-executes a game journal headlessly at full speed and shows where the
+// game stood at the end, or at a chosen turn.
+//
+//   replay [-m map.dat] [--turn N] [--render] game.journal
+//
+// The journal must have been recorded on the same board (-m takes a
+// map.dat or an image compiled by mapc). Dice and questions are checked
+// against the record on every turn and the first turn that differs is
+// reported. --turn N stops once N turns have been played; --render draws
+// the board there, as the game would have shown it.
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "journal.h"
+#include "map.h"
+#include "map_image.h"
+#include "player.h"
+#include "renderer.h"
+
+namespace {
+
+const char* statusName(PlayerStatus status) {
+    switch (status) {
+    case PlayerStatus::InJail: return "in jail";
+    case PlayerStatus::Bankrupt: return "bankrupt";
+    default: return "playing";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string mapPath = "map.dat";
+    std::string journalPath;
+    long stopTurn = -1;
+    bool render = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-m" && hasValue) mapPath = argv[++i];
+        else if (arg == "--turn" && hasValue) stopTurn = std::atol(argv[++i]);
+        else if (arg == "--render") render = true;
+        else if (journalPath.empty() && arg[0] != '-') journalPath = arg;
+        else {
+            journalPath.clear();
+            break;
+        }
+    }
+    if (journalPath.empty()) {
+        std::cerr << "usage: replay [-m map.dat] [--turn N] [--render] game.journal\n";
+        return 1;
+    }
+
+    JournalReader journal;
+    std::string error;
+    if (!journal.open(journalPath, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    // Same loading rule as tournament: a compiled image, else map.dat text.
+    MapImage image;
+    std::string imageError;
+    std::vector<UnitSpec> specs;
+    if (image.open(mapPath, imageError)) {
+        specs = image.toSpecs();
+    } else {
+        std::vector<std::string> errors;
+        parseMapFile(mapPath, specs, errors);
+        for (const auto& e : errors) std::cerr << e << "\n";
+    }
+    if (specs.empty()) {
+        std::cerr << mapPath << ": no units\n";
+        return 1;
+    }
+
+    int numPlayers = journal.getHeader().playerCount;
+    WorldMap map(numPlayers, specs);
+    WorldPlayer players(numPlayers, journal.getNames());
+    Game game(map, players);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = replayJournal(journal, game, stopTurn, error);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (render) {
+        TerminalRenderer renderer(std::cout);
+        renderer.draw(map, players, game.getCurrentPlayerIndex());
+        std::cout << "\n";
+    }
+
+    std::cout << journalPath << ": " << numPlayers << " players, " << journal.getTurns().size()
+              << " turns recorded";
+    if (journal.hasState()) std::cout << " from a saved game at turn " << journal.getState().turns;
+    std::cout << "\n";
+    std::cout << std::fixed << std::setprecision(1) << "replayed to turn " << game.getTurnCount()
+              << " in " << seconds * 1e3 << " ms (" << (seconds > 0 ? game.getTurnCount() / seconds : 0)
+              << " turns/s)" << (game.isOver() ? ", game over" : "") << "\n";
+    for (int i = 0; i < numPlayers; ++i) {
+        const Player* p = players.playerNow(i);
+        std::cout << (i == game.getCurrentPlayerIndex() && !game.isOver() ? "=>" : "  ")
+                  << "[" << i << "] " << std::setw(16) << std::left << p->getName() << std::right
+                  << " $" << std::setw(8) << p->getMoney() << "  at " << std::setw(4) << p->getLocation()
+                  << "  " << p->getUnitCount() << " units, " << statusName(p->getStatus()) << "\n";
+    }
+
+    if (!ok) {
+        std::cerr << "diverged: " << error << "\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "rng.h"
+#include "instrument.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define RNG_HAVE_AVX2_PATH 1
+#endif
+
+namespace {
+
+uint64_t splitmix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// A well-mixed 32-bit bijection (two multiply/xorshift rounds).
+inline uint32_t mix32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352DU;
+    x ^= x >> 15;
+    x *= 0x846CA68BU;
+    x ^= x >> 16;
+    return x;
+}
+
+inline uint32_t hashCounter(uint32_t k0, uint32_t k1, uint64_t counter) {
+    return mix32(mix32(uint32_t(counter) ^ k0) + (uint32_t(counter >> 32) ^ k1));
+}
+
+// Die from the top 24 bits: d = floor(r24 * 6 / 2^24) + 1. The 4 values of
+// r24 * 6 (mod 2^24) below 2^24 mod 6 are rejected, which makes every face
+// exactly equally likely. Returns 0 for a rejected draw.
+inline uint32_t dieFromBits(uint32_t r) {
+    uint32_t m = (r >> 8) * 6;
+    return (m & 0xFFFFFF) < 4 ? 0 : (m >> 24) + 1;
+}
+
+// Scalar fill; returns the number of counters consumed.
+uint64_t fillScalar(uint32_t k0, uint32_t k1, uint64_t counter, uint8_t* out, size_t n) {
+    uint64_t start = counter;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t d;
+        while ((d = dieFromBits(hashCounter(k0, k1, counter++))) == 0) {}
+        out[i] = uint8_t(d);
+    }
+    return counter - start;
+}
+
+#ifdef RNG_HAVE_AVX2_PATH
+__attribute__((target("avx2")))
+inline __m256i mix32x8(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7FEB352D));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(int(0x846CA68BU)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+}
+
+// Eight dice per iteration. A block whose counters straddle a 2^32 boundary
+// or that hits a rejected draw is redone by the scalar path, so the output
+// is bit-identical to fillScalar().
+__attribute__((target("avx2")))
+uint64_t fillAvx2(uint32_t k0, uint32_t k1, uint64_t counter, uint8_t* out, size_t n) {
+    uint64_t start = counter;
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i six = _mm256_set1_epi32(6);
+    const __m256i low24 = _mm256_set1_epi32(0xFFFFFF);
+    const __m256i four = _mm256_set1_epi32(4);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i key0 = _mm256_set1_epi32(int(k0));
+
+    size_t i = 0;
+    while (i + 8 <= n) {
+        uint32_t lo = uint32_t(counter);
+        if (lo > 0xFFFFFFFFU - 7) {
+            counter += fillScalar(k0, k1, counter, out + i, 8);
+            i += 8;
+            continue;
+        }
+        __m256i c = _mm256_add_epi32(_mm256_set1_epi32(int(lo)), lane);
+        __m256i hi = _mm256_set1_epi32(int(uint32_t(counter >> 32) ^ k1));
+        __m256i r = mix32x8(_mm256_add_epi32(mix32x8(_mm256_xor_si256(c, key0)), hi));
+        __m256i m = _mm256_mullo_epi32(_mm256_srli_epi32(r, 8), six);
+        // Rejected lanes have (m & 0xFFFFFF) < 4, i.e. 4 > (m & 0xFFFFFF).
+        __m256i reject = _mm256_cmpgt_epi32(four, _mm256_and_si256(m, low24));
+        if (!_mm256_testz_si256(reject, reject)) {
+            counter += fillScalar(k0, k1, counter, out + i, 8);
+            i += 8;
+            continue;
+        }
+        __m256i d = _mm256_add_epi32(_mm256_srli_epi32(m, 24), one);
+        // Narrow 8 x int32 to 8 bytes.
+        __m128i d16 = _mm_packs_epi32(_mm256_castsi256_si128(d), _mm256_extracti128_si256(d, 1));
+        __m128i d8 = _mm_packus_epi16(d16, d16);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), d8);
+        counter += 8;
+        i += 8;
+    }
+    counter += fillScalar(k0, k1, counter, out + i, n - i);
+    return counter - start;
+}
+
+// RngLanes::roll() for all eight lanes at once: hands out the ready dice
+// of the masked lanes and draws their next ones. Returns the masked lanes
+// whose new draw was rejected, for the caller to redo one by one.
+__attribute__((target("avx2")))
+unsigned rollLanesAvx2(const uint32_t* k0, const uint32_t* k1, uint32_t* lo, uint32_t* hi,
+                       int32_t* ready, unsigned mask, int32_t* out) {
+    const __m256i bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i six = _mm256_set1_epi32(6);
+    const __m256i low24 = _mm256_set1_epi32(0xFFFFFF);
+    const __m256i four = _mm256_set1_epi32(4);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i roll = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(mask)), bit), bit);
+    __m256i d = _mm256_load_si256(reinterpret_cast<const __m256i*>(ready));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(out), _mm256_and_si256(roll, d));
+
+    __m256i c = _mm256_load_si256(reinterpret_cast<const __m256i*>(lo));
+    __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(hi));
+    __m256i r = mix32x8(_mm256_add_epi32(
+        mix32x8(_mm256_xor_si256(c, _mm256_load_si256(reinterpret_cast<const __m256i*>(k0)))),
+        _mm256_xor_si256(h, _mm256_load_si256(reinterpret_cast<const __m256i*>(k1)))));
+    __m256i m = _mm256_mullo_epi32(_mm256_srli_epi32(r, 8), six);
+    __m256i reject = _mm256_cmpgt_epi32(four, _mm256_and_si256(m, low24));
+    __m256i take = _mm256_andnot_si256(reject, roll);
+    d = _mm256_blendv_epi8(d, _mm256_add_epi32(_mm256_srli_epi32(m, 24), one), take);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(ready), d);
+    // counter += 1 in the taken lanes, carrying into the high word.
+    __m256i next = _mm256_sub_epi32(c, take);
+    __m256i carry = _mm256_and_si256(take, _mm256_cmpeq_epi32(next, _mm256_setzero_si256()));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lo), next);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(hi), _mm256_sub_epi32(h, carry));
+    return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(roll, reject))));
+}
+
+bool cpuHasAvx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+#endif
+
+uint64_t streamKey(uint64_t masterSeed, uint64_t stream) {
+    return splitmix64(splitmix64(masterSeed) ^ splitmix64(~stream));
+}
+
+} // namespace
+
+// ================== Rng ==================
+void Rng::seed(uint64_t masterSeed, uint64_t stream) {
+    uint64_t key = streamKey(masterSeed, stream);
+    key0_ = uint32_t(key);
+    key1_ = uint32_t(key >> 32);
+    counter_ = 0;
+    bufferPos_ = 0;
+    buffered_ = 0;
+}
+
+uint32_t Rng::next() {
+    return hashCounter(key0_, key1_, counter_++);
+}
+
+void Rng::rollDice(uint8_t* out, size_t n) {
+#ifdef RNG_HAVE_AVX2_PATH
+    if (cpuHasAvx2()) {
+        counter_ += fillAvx2(key0_, key1_, counter_, out, n);
+        return;
+    }
+#endif
+    counter_ += fillScalar(key0_, key1_, counter_, out, n);
+}
+
+void Rng::savePosition(uint64_t& key, uint64_t& batchCounter, uint32_t& taken) const {
+    key = getKey();
+    batchCounter = buffered_ ? bufferStart_ : counter_;
+    taken = buffered_ ? bufferPos_ : 0;
+}
+
+void Rng::restorePosition(uint64_t key, uint64_t batchCounter, uint32_t taken) {
+    key0_ = uint32_t(key);
+    key1_ = uint32_t(key >> 32);
+    counter_ = batchCounter;
+    bufferPos_ = 0;
+    buffered_ = 0;
+    if (taken > 0) {
+        refill();
+        bufferPos_ = taken > kBufferSize ? kBufferSize : taken;
+    }
+}
+
+void Rng::refill() {
+    INSTRUMENT_SCOPE(Dice);
+    bufferStart_ = counter_;
+    rollDice(buffer_, kBufferSize);
+    bufferPos_ = 0;
+    buffered_ = kBufferSize;
+}
+
+// ================== Rng Lanes ==================
+void RngLanes::seed(int lane, uint64_t masterSeed, uint64_t stream) {
+    uint64_t key = streamKey(masterSeed, stream);
+    key0_[lane] = uint32_t(key);
+    key1_[lane] = uint32_t(key >> 32);
+    counterLo_[lane] = 0;
+    counterHi_[lane] = 0;
+    draw(lane);
+}
+
+// Hashes the lane's next die into ready_, past any rejected draws.
+void RngLanes::draw(int lane) {
+    uint64_t counter = (uint64_t(counterHi_[lane]) << 32) | counterLo_[lane];
+    uint32_t d;
+    while ((d = dieFromBits(hashCounter(key0_[lane], key1_[lane], counter++))) == 0) {}
+    counterLo_[lane] = uint32_t(counter);
+    counterHi_[lane] = uint32_t(counter >> 32);
+    ready_[lane] = int32_t(d);
+}
+
+int RngLanes::rollLane(int lane) {
+    int die = ready_[lane];
+    draw(lane);
+    return die;
+}
+
+void RngLanes::roll(unsigned mask, int32_t* out) {
+#ifdef RNG_HAVE_AVX2_PATH
+    if (cpuHasAvx2()) {
+        // A rejected draw (4 in 2^24) is redone on its own.
+        unsigned redo = rollLanesAvx2(key0_, key1_, counterLo_, counterHi_, ready_, mask, out);
+        for (int lane = 0; redo; ++lane, redo >>= 1) {
+            if (redo & 1) draw(lane);
+        }
+        return;
+    }
+#endif
+    for (int lane = 0; lane < kLanes; ++lane) {
+        out[lane] = (mask >> lane) & 1 ? rollLane(lane) : 0;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef RNG__
+#define RNG__
+
+#include <cstddef>
+#include <cstdint>
+
+// ================== Rng ==================
+// Counter-based generator: the n-th output of a stream is a pure hash of
+// (key, n), so streams never overlap, any position can be reached in O(1)
+// and thousands of outputs can be produced in parallel SIMD lanes.
+//
+// The key is derived from a master seed and a stream number, which lets one
+// seed drive an independent stream per game or per thread:
+//
+//   Rng rng(masterSeed, gameIndex);
+//
+// Dice are unbiased (rejection sampling) and the batched rollDice() yields
+// exactly the same sequence as repeated rollDie() calls.
+class Rng {
+public:
+    explicit Rng(uint64_t masterSeed = 0, uint64_t stream = 0) { seed(masterSeed, stream); }
+
+    void seed(uint64_t masterSeed, uint64_t stream = 0);
+
+    // Raw 32-bit output at the current counter, then advance.
+    uint32_t next();
+
+    // One die in 1..6, served from an internal batch.
+    int rollDie() {
+        if (buffered_ == bufferPos_) refill();
+        return buffer_[bufferPos_++];
+    }
+
+    // Fills out[0..n) with dice in 1..6 using the widest SIMD available.
+    void rollDice(uint8_t* out, size_t n);
+
+    // Jump ahead by n raw outputs without generating them.
+    void skip(uint64_t n) { counter_ += n; }
+
+    uint64_t getCounter() const { return counter_; }
+    uint64_t getKey() const { return (uint64_t(key1_) << 32) | key0_; }
+
+    // Where the dice stream stands: the key, the counter the current batch
+    // was generated from and how many dice were taken from it. Restoring
+    // this continues with exactly the same dice (raw next() calls made
+    // after the last batch are not tracked).
+    void savePosition(uint64_t& key, uint64_t& batchCounter, uint32_t& taken) const;
+    void restorePosition(uint64_t key, uint64_t batchCounter, uint32_t taken);
+
+private:
+    static constexpr int kBufferSize = 256;
+
+    void refill();
+
+    uint32_t key0_ = 0;
+    uint32_t key1_ = 0;
+    uint64_t counter_ = 0;
+    uint64_t bufferStart_ = 0;
+    uint8_t buffer_[kBufferSize];
+    int bufferPos_ = 0;
+    int buffered_ = 0;
+};
+
+// ================== Rng Lanes ==================
+// kLanes streams side by side for lockstep SIMD code: roll() draws the next
+// die of every lane in a mask at once, and lane i yields exactly the dice
+// of Rng(masterSeed, stream_i).rollDie(). Each lane keeps its next die
+// hashed in advance, so a roll hands out dice that are already there and
+// a lane that sits a turn out costs nothing.
+class RngLanes {
+public:
+    static constexpr int kLanes = 8;
+
+    void seed(int lane, uint64_t masterSeed, uint64_t stream);
+
+    // Writes the next die of each lane whose bit is set in mask to
+    // out[lane] (32-byte aligned); the other lanes get 0 and keep their die.
+    void roll(unsigned mask, int32_t* out);
+    int rollLane(int lane);
+
+private:
+    void draw(int lane);
+
+    alignas(32) uint32_t key0_[kLanes] = {};
+    alignas(32) uint32_t key1_[kLanes] = {};
+    alignas(32) uint32_t counterLo_[kLanes] = {};
+    alignas(32) uint32_t counterHi_[kLanes] = {};
+    alignas(32) int32_t ready_[kLanes] = {};
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "scheduler.h"
+#include <thread>
+
+
+// ================== Work Stealing Scheduler ==================
+WorkStealingScheduler::WorkStealingScheduler(int numWorkers)
+    : numWorkers_(numWorkers < 1 ? 1 : numWorkers), slices_(numWorkers_) {}
+
+void WorkStealingScheduler::run(long count, const std::function<void(int, long)>& body) {
+    // Hand out the range in equal contiguous slices.
+    for (int w = 0; w < numWorkers_; ++w) {
+        slices_[w].begin = count * w / numWorkers_;
+        slices_[w].end = count * (w + 1) / numWorkers_;
+    }
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < numWorkers_; ++w) {
+        threads.emplace_back([this, w, &body] { workerLoop(w, body); });
+    }
+    workerLoop(0, body); // The calling thread is worker 0.
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void WorkStealingScheduler::workerLoop(int worker, const std::function<void(int, long)>& body) {
+    long index = 0;
+    while (true) {
+        while (takeOwn(worker, index)) {
+            body(worker, index);
+        }
+        if (!steal(worker)) {
+            return; // Every slice is empty: all work has been handed out.
+        }
+    }
+}
+
+bool WorkStealingScheduler::takeOwn(int worker, long& index) {
+    Slice& s = slices_[worker];
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (s.begin >= s.end) return false;
+    index = s.begin++;
+    return true;
+}
+
+bool WorkStealingScheduler::steal(int thief) {
+    // Scan the other workers starting after ourselves and rob the first one
+    // that still has at least one index left.
+    for (int k = 1; k < numWorkers_; ++k) {
+        Slice& victim = slices_[(thief + k) % numWorkers_];
+        long begin = 0, end = 0;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            long left = victim.end - victim.begin;
+            if (left <= 0) continue;
+            long take = (left + 1) / 2;
+            end = victim.end;
+            begin = end - take;
+            victim.end = begin;
+        }
+        Slice& mine = slices_[thief];
+        std::lock_guard<std::mutex> guard(mine.lock);
+        mine.begin = begin;
+        mine.end = end;
+        return true;
+    }
+    return false;
+}
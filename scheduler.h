@@ -0,0 +1,37 @@
+#ifndef SCHEDULER__
+#define SCHEDULER__
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// ================== Work Stealing Scheduler ==================
+// Runs body(worker, index) for every index in [0, count) on numWorkers
+// threads. Each worker starts with an even slice of the index range and
+// takes one index at a time from its front; a worker that runs dry steals
+// the back half of the first non-empty slice after its own. Long games
+// therefore never leave a core idle while others still have work queued.
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(int numWorkers);
+
+    int getWorkerCount() const { return numWorkers_; }
+    void run(long count, const std::function<void(int worker, long index)>& body);
+
+private:
+    // One range per worker, padded so neighbours don't share a cache line.
+    struct alignas(64) Slice {
+        std::mutex lock;
+        long begin = 0;
+        long end = 0;
+    };
+
+    bool takeOwn(int worker, long& index);
+    bool steal(int thief);
+    void workerLoop(int worker, const std::function<void(int, long)>& body);
+
+    int numWorkers_ = 1;
+    std::vector<Slice> slices_;
+};
+
+#endif
@@ -0,0 +1,568 @@
+// Game server: hosts many independent tables in one process behind a
+// Unix-domain socket. Each table is a WorldMap/WorldPlayer pair driven by
+// its own Game; players talk to it with a line protocol.
+//
+//   server [-s monopoly.sock] [-t threads] [-m map.dat] [--no-reload]
+//
+// The main thread accepts connections and hands each one to a reactor
+// thread (round robin). A reactor runs its own epoll loop and owns its
+// connections and the tables they create, so a table is only ever touched
+// by one thread and no locks are taken per command. Each table's game is
+// a GameSession coroutine on its reactor's TurnScheduler: it suspends
+// while waiting for a ROLL or an ANSWER and is resumed when the command
+// arrives, so a waiting player costs a coroutine frame, not a thread.
+//
+// One command per line; every reply line starts with a keyword. Tables
+// belong to the connection that created them and close with it.
+//
+//   NEW <players> [seed]   -> TABLE <id>
+//   ROLL <id>              -> SKIP <id> <player> jail|bankrupt
+//                           | ASK <id> <player> BUY|UPGRADE <unit> <price> <money>
+//                           | TURN <id> <player> <dice> <location> <money>
+//   ANSWER <id> YES|NO     -> TURN ...            (only after ASK)
+//   STATE <id>             -> STATE <id> <turns> <current> <money>:<location>:<status> ...
+//   CLOSE <id>             -> CLOSED <id>
+//   STATS                  -> STATS tables <n> connections <n> turns <n> turn_us <avg> rss_kb <n> board <version>
+//   otherwise              -> ERR <reason>
+//
+// A TURN that ends the game is followed by OVER <id> <winner>, and so is a
+// ROLL on a finished table.
+//
+// Edits to the map file are picked up while the server runs (unless
+// --no-reload): NEW tables get the new board, tables already playing keep
+// the one they started with. STATS shows the current board version.
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "map.h"
+#include "map_watch.h"
+#include "player.h"
+#include "policy.h"
+#include "session.h"
+
+namespace {
+
+const int kMaxTablePlayers = 64;
+const size_t kMaxLine = 4096;
+
+std::atomic<long> gTables{0};
+std::atomic<long> gConnections{0};
+std::atomic<int> gNextTableId{1};
+volatile std::sig_atomic_t gStop = 0;
+
+void onStopSignal(int) {
+    gStop = 1;
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+long residentKb() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// ================== Table ==================
+// One game, every seat played over the connection. The session reports
+// each step as a reply line on the owner's output buffer (the connection
+// outlives its tables). The table holds on to the board version it was
+// built from for as long as it plays.
+struct Table {
+    Table(int id, int owner, std::string& out, int numPlayers, std::shared_ptr<const Board> board,
+          std::vector<std::string>& names, uint64_t seed, TurnScheduler& scheduler)
+        : id(id), owner(owner), board(std::move(board)), map(numPlayers, this->board->specs),
+          players(numPlayers, names), game(map, players, seed), session(game, scheduler) {
+        session.setEventSink([this, &out](const TurnEvent& event) { report(out, event); });
+        session.start();
+    }
+
+    void report(std::string& out, const TurnEvent& event);
+
+    int id;
+    int owner;          // fd of the creating connection
+    std::shared_ptr<const Board> board;
+    WorldMap map;
+    WorldPlayer players;
+    Game game;
+    GameSession session;
+    bool turnCompleted = false;
+};
+
+void Table::report(std::string& out, const TurnEvent& event) {
+    const std::string prefix = std::to_string(id) + " " + std::to_string(event.player);
+    switch (event.kind) {
+    case TurnEvent::Kind::Skipped:
+        out += "SKIP " + prefix + (event.outcome == TurnOutcome::SkippedJail ? " jail\n" : " bankrupt\n");
+        turnCompleted = true;
+        break;
+    case TurnEvent::Kind::Asked:
+        out += "ASK " + prefix + (event.decision.kind == DecisionKind::Buy ? " BUY " : " UPGRADE ") +
+               std::to_string(event.decision.unitId) + " " + std::to_string(event.decision.price) + " " +
+               std::to_string(event.decision.money) + "\n";
+        break;
+    case TurnEvent::Kind::Moved: {
+        const Player* p = players.playerNow(event.player);
+        out += "TURN " + prefix + " " + std::to_string(game.getLastDiceRoll()) + " " +
+               std::to_string(p->getLocation()) + " " + std::to_string(p->getMoney()) + "\n";
+        turnCompleted = true;
+        break;
+    }
+    case TurnEvent::Kind::Over:
+        out += "OVER " + prefix + "\n";
+        break;
+    case TurnEvent::Kind::Rolled:
+        break;
+    }
+}
+
+struct Connection {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    bool wantWrite = false;
+    std::vector<int> tables;
+};
+
+// ================== Reactor ==================
+class Reactor {
+public:
+    explicit Reactor(const MapWatcher& boards);
+    ~Reactor();
+
+    void start() { thread_ = std::thread([this] { run(); }); }
+    void stop();
+
+    // Called from the accept thread: queue the socket and wake the loop.
+    void adopt(int fd);
+
+    long getTurns() const { return turns_.load(std::memory_order_relaxed); }
+    long getTurnNanos() const { return turnNanos_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void takeIncoming();
+    void onReadable(Connection& conn);
+    void flush(Connection& conn);
+    void closeConnection(int fd);
+
+    void handle(Connection& conn, const std::string& line);
+    Table* find(Connection& conn, std::istringstream& args);
+    void roll(Connection& conn, Table& table);
+    void answer(Connection& conn, Table& table, bool accept);
+    void runTable(Table& table);
+    // Adds the processing time since start; a turn is counted once it has
+    // completed (the part before an ASK only adds time).
+    void countTurn(std::chrono::steady_clock::time_point start, bool completed);
+
+    const MapWatcher& boards_;
+    std::vector<std::string> names_;
+    int epoll_ = -1;
+    int wake_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+
+    std::mutex incomingLock_;
+    std::vector<int> incoming_;
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    std::unordered_map<int, std::unique_ptr<Table>> tables_;
+    TurnScheduler scheduler_;
+
+    std::atomic<long> turns_{0};
+    std::atomic<long> turnNanos_{0};
+};
+
+std::vector<std::unique_ptr<Reactor>> gReactors;
+
+Reactor::Reactor(const MapWatcher& boards) : boards_(boards) {
+    for (int i = 0; i < kMaxTablePlayers; ++i) {
+        names_.push_back("P" + std::to_string(i));
+    }
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &ev);
+}
+
+Reactor::~Reactor() {
+    stop();
+    for (auto& [fd, conn] : connections_) {
+        close(fd);
+    }
+    close(wake_);
+    close(epoll_);
+}
+
+void Reactor::stop() {
+    if (!thread_.joinable()) return;
+    stopping_ = true;
+    uint64_t one = 1;
+    (void)!write(wake_, &one, sizeof(one));
+    thread_.join();
+}
+
+void Reactor::adopt(int fd) {
+    {
+        std::lock_guard<std::mutex> lock(incomingLock_);
+        incoming_.push_back(fd);
+    }
+    uint64_t one = 1;
+    (void)!write(wake_, &one, sizeof(one));
+}
+
+void Reactor::run() {
+    epoll_event events[256];
+    while (!stopping_) {
+        int n = epoll_wait(epoll_, events, 256, -1);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_) {
+                uint64_t count;
+                while (read(wake_, &count, sizeof(count)) > 0) {}
+                takeIncoming();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) continue;
+            Connection& conn = *it->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flush(conn);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                onReadable(conn);
+            }
+        }
+    }
+}
+
+void Reactor::takeIncoming() {
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> lock(incomingLock_);
+        fds.swap(incoming_);
+    }
+    for (int fd : fds) {
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        connections_[fd] = std::move(conn);
+        gConnections++;
+    }
+}
+
+void Reactor::onReadable(Connection& conn) {
+    const int fd = conn.fd;
+    char buf[65536];
+    bool closed = false;
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            conn.in.append(buf, n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) closed = true;
+        if (n < 0 && errno == EINTR) continue;
+        break;
+    }
+
+    size_t start = 0, end;
+    while ((end = conn.in.find('\n', start)) != std::string::npos) {
+        std::string line = conn.in.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = end + 1;
+        if (!line.empty()) handle(conn, line);
+    }
+    conn.in.erase(0, start);
+    if (conn.in.size() > kMaxLine) {
+        conn.out += "ERR line too long\n";
+        closed = true;
+    }
+
+    flush(conn);
+    if (closed) closeConnection(fd);
+}
+
+void Reactor::flush(Connection& conn) {
+    size_t sent = 0;
+    while (sent < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + sent, conn.out.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        break;
+    }
+    conn.out.erase(0, sent);
+
+    // Only ask for EPOLLOUT while something is queued.
+    bool wantWrite = !conn.out.empty();
+    if (wantWrite != conn.wantWrite) {
+        conn.wantWrite = wantWrite;
+        epoll_event ev{};
+        ev.events = uint32_t(EPOLLIN | EPOLLRDHUP) | (wantWrite ? uint32_t(EPOLLOUT) : 0u);
+        ev.data.fd = conn.fd;
+        epoll_ctl(epoll_, EPOLL_CTL_MOD, conn.fd, &ev);
+    }
+}
+
+void Reactor::closeConnection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) return;
+    for (int id : it->second->tables) {
+        if (tables_.erase(id)) gTables--;
+    }
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(it);
+    gConnections--;
+}
+
+Table* Reactor::find(Connection& conn, std::istringstream& args) {
+    int id = 0;
+    if (!(args >> id)) {
+        conn.out += "ERR missing table id\n";
+        return nullptr;
+    }
+    auto it = tables_.find(id);
+    if (it == tables_.end() || it->second->owner != conn.fd) {
+        conn.out += "ERR no table " + std::to_string(id) + "\n";
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+void Reactor::handle(Connection& conn, const std::string& line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "NEW") {
+        int numPlayers = 0;
+        uint64_t seed = 0;
+        if (!(args >> numPlayers) || numPlayers < 1 || numPlayers > kMaxTablePlayers) {
+            conn.out += "ERR players must be 1.." + std::to_string(kMaxTablePlayers) + "\n";
+            return;
+        }
+        if (!(args >> seed)) seed = uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+        int id = gNextTableId++;
+        conn.out += "TABLE " + std::to_string(id) + "\n";
+        tables_[id] = std::make_unique<Table>(id, conn.fd, conn.out, numPlayers, boards_.current(), names_, seed,
+                                              scheduler_);
+        conn.tables.push_back(id);
+        gTables++;
+        // Runs the game up to its first wait for a ROLL.
+        scheduler_.runReady();
+    }
+    else if (command == "ROLL") {
+        if (Table* table = find(conn, args)) roll(conn, *table);
+    }
+    else if (command == "ANSWER") {
+        Table* table = find(conn, args);
+        if (!table) return;
+        std::string reply;
+        args >> reply;
+        if (table->session.waitingFor() != SessionWait::Answer) {
+            conn.out += "ERR table " + std::to_string(table->id) + " asked nothing\n";
+        } else if (reply != "YES" && reply != "NO") {
+            conn.out += "ERR answer YES or NO\n";
+        } else {
+            answer(conn, *table, reply == "YES");
+        }
+    }
+    else if (command == "STATE") {
+        Table* table = find(conn, args);
+        if (!table) return;
+        const Game& game = table->game;
+        std::string out = "STATE " + std::to_string(table->id) + " " + std::to_string(game.getTurnCount()) +
+                          " " + std::to_string(game.getCurrentPlayerIndex());
+        for (int i = 0; i < table->players.getPlayerCount(); ++i) {
+            const Player* p = table->players.playerNow(i);
+            out += " " + std::to_string(p->getMoney()) + ":" + std::to_string(p->getLocation()) + ":" +
+                   std::to_string(static_cast<int>(p->getStatus()));
+        }
+        conn.out += out + "\n";
+    }
+    else if (command == "CLOSE") {
+        Table* table = find(conn, args);
+        if (!table) return;
+        int id = table->id;
+        tables_.erase(id);
+        gTables--;
+        auto& owned = conn.tables;
+        owned.erase(std::remove(owned.begin(), owned.end(), id), owned.end());
+        conn.out += "CLOSED " + std::to_string(id) + "\n";
+    }
+    else if (command == "STATS") {
+        long turns = 0, nanos = 0;
+        for (const auto& reactor : gReactors) {
+            turns += reactor->getTurns();
+            nanos += reactor->getTurnNanos();
+        }
+        std::ostringstream out;
+        out << "STATS tables " << gTables.load() << " connections " << gConnections.load()
+            << " turns " << turns << " turn_us " << (turns ? nanos / 1000.0 / turns : 0.0)
+            << " rss_kb " << residentKb() << " board " << boards_.current()->version << "\n";
+        conn.out += out.str();
+    }
+    else {
+        conn.out += "ERR unknown command\n";
+    }
+}
+
+void Reactor::roll(Connection& conn, Table& table) {
+    const std::string id = std::to_string(table.id);
+    if (table.session.isFinished()) {
+        conn.out += "OVER " + id + " " + std::to_string(table.game.getLeader()) + "\n";
+        return;
+    }
+    if (!table.session.deliverRoll()) {
+        conn.out += "ERR table " + id + " is waiting for an answer\n";
+        return;
+    }
+    runTable(table);
+}
+
+void Reactor::answer(Connection& /*conn*/, Table& table, bool accept) {
+    table.session.deliverAnswer(accept);
+    runTable(table);
+}
+
+// Resumes the table's coroutine up to its next wait; replies are written
+// by the session's event sink on the way.
+void Reactor::runTable(Table& table) {
+    auto start = std::chrono::steady_clock::now();
+    table.turnCompleted = false;
+    scheduler_.runReady();
+    countTurn(start, table.turnCompleted);
+}
+
+void Reactor::countTurn(std::chrono::steady_clock::time_point start, bool completed) {
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    // Single writer: this reactor's thread.
+    if (completed) turns_.store(turns_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    turnNanos_.store(turnNanos_.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string socketPath = "monopoly.sock";
+    std::string mapPath = "map.dat";
+    int numThreads = 2;
+    bool reload = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-s" && hasValue) socketPath = argv[++i];
+        else if (arg == "-m" && hasValue) mapPath = argv[++i];
+        else if (arg == "-t" && hasValue) numThreads = std::atoi(argv[++i]);
+        else if (arg == "--no-reload") reload = false;
+        else {
+            std::cerr << "usage: server [-s monopoly.sock] [-t threads] [-m map.dat] [--no-reload]\n";
+            return 1;
+        }
+    }
+    if (numThreads < 1) numThreads = 1;
+
+    MapWatcher boards(mapPath, &std::cerr);
+    std::vector<std::string> errors;
+    bool loaded = boards.load(errors);
+    for (const auto& error : errors) std::cerr << error << "\n";
+    if (!loaded) {
+        std::cerr << mapPath << ": no units\n";
+        return 1;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << socketPath << ": path too long\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(socketPath.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listener, 1024) != 0) {
+        std::cerr << socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // SIGINT/SIGTERM interrupt accept(); shut down cleanly from there.
+    struct sigaction stopAction {};
+    stopAction.sa_handler = onStopSignal;
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    for (int t = 0; t < numThreads; ++t) {
+        gReactors.push_back(std::make_unique<Reactor>(boards));
+        gReactors.back()->start();
+    }
+    if (reload) boards.start();
+    std::cerr << "listening on " << socketPath << " with " << numThreads << " threads\n";
+
+    size_t next = 0;
+    while (!gStop) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "accept: " << std::strerror(errno) << "\n";
+            break;
+        }
+        if (!setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+        gReactors[next]->adopt(fd);
+        next = (next + 1) % gReactors.size();
+    }
+
+    for (auto& reactor : gReactors) {
+        reactor->stop();
+    }
+    gReactors.clear();
+    boards.stop();
+    close(listener);
+    unlink(socketPath.c_str());
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "session.h"
+
+
+// ================== Game Task ==================
+GameTask& GameTask::operator=(GameTask&& other) noexcept {
+    if (this != &other) {
+        if (handle_) handle_.destroy();
+        handle_ = other.handle_;
+        other.handle_ = nullptr;
+    }
+    return *this;
+}
+
+GameTask::~GameTask() {
+    if (handle_) handle_.destroy();
+}
+
+// ================== Turn Scheduler ==================
+size_t TurnScheduler::runReady() {
+    size_t count = 0;
+    while (!ready_.empty()) {
+        std::coroutine_handle<> handle = ready_.front();
+        ready_.pop_front();
+        if (!handle.done()) handle.resume();
+        ++count;
+    }
+    return count;
+}
+
+// ================== Game Session ==================
+GameSession::GameSession(Game& game, TurnScheduler& scheduler)
+    : game_(game), scheduler_(scheduler), bots_(game.getPlayers().getPlayerCount(), nullptr) {
+    for (size_t i = 0; i < bots_.size(); ++i) {
+        game_.setPolicy(i, &answers_);
+    }
+}
+
+void GameSession::setBot(int seat, DecisionPolicy* policy) {
+    if (seat >= 0 && seat < int(bots_.size())) {
+        bots_[seat] = policy;
+    }
+}
+
+void GameSession::start() {
+    task_ = play();
+    started_ = true;
+    scheduler_.schedule(task_.handle());
+}
+
+bool GameSession::resume(SessionWait expected) {
+    if (waiting_ != expected) return false;
+    waiting_ = SessionWait::None;
+    scheduler_.schedule(handle_);
+    return true;
+}
+
+bool GameSession::deliverRoll() {
+    return resume(SessionWait::Roll);
+}
+
+bool GameSession::deliverAnswer(bool accept) {
+    if (waiting_ != SessionWait::Answer) return false;
+    answer_ = accept;
+    return resume(SessionWait::Answer);
+}
+
+// A bot's roll needs no input.
+GameSession::InputAwaiter GameSession::rollFor(int seat) {
+    return InputAwaiter{*this, SessionWait::Roll, bots_[seat] != nullptr};
+}
+
+// A bot answers right here; anyone else is asked and the game waits.
+GameSession::InputAwaiter GameSession::answerFor(const Decision& decision) {
+    DecisionPolicy* bot = bots_[decision.playerId];
+    if (bot) {
+        answer_ = bot->decide(decision);
+        return InputAwaiter{*this, SessionWait::Answer, true};
+    }
+    pending_ = decision;
+    TurnEvent asked;
+    asked.kind = TurnEvent::Kind::Asked;
+    asked.player = decision.playerId;
+    asked.decision = decision;
+    emit(asked);
+    return InputAwaiter{*this, SessionWait::Answer, false};
+}
+
+GameTask GameSession::play() {
+    // Same stopping rule as Game::runToCompletion.
+    while (!game_.isOver() && (maxTurns_ < 0 || game_.getTurnCount() < maxTurns_)) {
+        TurnEvent event;
+        event.player = game_.getCurrentPlayerIndex();
+        co_await rollFor(event.player);
+
+        event.outcome = game_.beginTurn();
+        if (event.outcome != TurnOutcome::Moved) {
+            event.kind = TurnEvent::Kind::Skipped;
+            emit(event);
+            continue;
+        }
+        event.kind = TurnEvent::Kind::Rolled;
+        emit(event);
+
+        // The answer is collected before the visit runs, then handed to the
+        // visit through the scripted policy.
+        Decision decision;
+        if (game_.pendingDecision(decision)) {
+            bool accept = co_await answerFor(decision);
+            answers_.clear();
+            answers_.push(accept);
+        }
+        game_.finishTurn();
+
+        event.kind = TurnEvent::Kind::Moved;
+        emit(event);
+    }
+
+    TurnEvent over;
+    over.kind = TurnEvent::Kind::Over;
+    over.player = game_.getLeader();
+    emit(over);
+}
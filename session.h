@@ -0,0 +1,137 @@
+#ifndef SESSION__
+#define SESSION__
+
+#include <coroutine>
+#include <deque>
+#include <functional>
+
+#include "game.h"
+#include "policy.h"
+
+// ================== Game Task ==================
+// Owner of a game coroutine. The coroutine starts suspended and is only
+// ever resumed by a TurnScheduler; destroying the task destroys the frame
+// wherever it is suspended.
+class GameTask {
+public:
+    struct promise_type {
+        GameTask get_return_object() { return GameTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    GameTask() = default;
+    explicit GameTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    GameTask(GameTask&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+    GameTask& operator=(GameTask&& other) noexcept;
+    GameTask(const GameTask&) = delete;
+    GameTask& operator=(const GameTask&) = delete;
+    ~GameTask();
+
+    std::coroutine_handle<> handle() const { return handle_; }
+    bool done() const { return !handle_ || handle_.done(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// ================== Turn Scheduler ==================
+// Run queue for game coroutines on one thread. Sessions put themselves
+// back on the queue when their input arrives; runReady() resumes them in
+// that order until nothing is left to run.
+class TurnScheduler {
+public:
+    void schedule(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+    // Returns how many resumptions ran.
+    size_t runReady();
+    bool idle() const { return ready_.empty(); }
+
+private:
+    std::deque<std::coroutine_handle<>> ready_;
+};
+
+// ================== Game Session ==================
+// One Game played as a coroutine: roll, move, visit (co_await the buy or
+// upgrade answer), bankruptcy check, next player. Seats with a bot policy
+// answer on the spot and their awaits never suspend, so an all-bot game
+// runs to the end in a single resume. Seats without one suspend the game
+// until deliverRoll() / deliverAnswer() supply the input, so a waiting
+// player costs a suspended frame instead of a blocked thread.
+//
+// What happens is reported through the event callback, from inside the
+// coroutine, in game order.
+enum class SessionWait { None, Roll, Answer };
+
+// Rolled comes between the move and the visit (a frontend redraws there),
+// Moved once the turn is complete.
+struct TurnEvent {
+    enum class Kind { Skipped, Rolled, Asked, Moved, Over };
+    Kind kind = Kind::Moved;
+    int player = 0;
+    TurnOutcome outcome = TurnOutcome::Moved;  // Skipped: why
+    Decision decision;                         // Asked: the question
+};
+
+class GameSession {
+public:
+    using EventSink = std::function<void(const TurnEvent&)>;
+
+    // Takes over the game's policies; set bots with setBot().
+    GameSession(Game& game, TurnScheduler& scheduler);
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    void setBot(int seat, DecisionPolicy* policy);
+    void setEventSink(EventSink sink) { sink_ = std::move(sink); }
+    // Stop after this many turns even if nobody has won.
+    void setTurnLimit(long maxTurns) { maxTurns_ = maxTurns; }
+
+    // Creates the coroutine and queues it on the scheduler.
+    void start();
+
+    // Input for a waiting seat; false if the game is not waiting for it.
+    // The game continues on the scheduler's next runReady().
+    bool deliverRoll();
+    bool deliverAnswer(bool accept);
+
+    SessionWait waitingFor() const { return waiting_; }
+    const Decision& getPendingDecision() const { return pending_; }
+    bool isFinished() const { return task_.done() && started_; }
+
+private:
+    struct InputAwaiter {
+        GameSession& session;
+        SessionWait wait;
+        bool ready;
+        bool await_ready() const noexcept { return ready; }
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            session.waiting_ = wait;
+            session.handle_ = handle;
+        }
+        bool await_resume() const noexcept { return session.answer_; }
+    };
+
+    GameTask play();
+    InputAwaiter rollFor(int seat);
+    InputAwaiter answerFor(const Decision& decision);
+    void emit(const TurnEvent& event) { if (sink_) sink_(event); }
+    bool resume(SessionWait expected);
+
+    Game& game_;
+    TurnScheduler& scheduler_;
+    std::vector<DecisionPolicy*> bots_;
+    ScriptedPolicy answers_;
+    EventSink sink_;
+    long maxTurns_ = -1;
+
+    GameTask task_;
+    std::coroutine_handle<> handle_;
+    SessionWait waiting_ = SessionWait::None;
+    Decision pending_;
+    bool answer_ = false;
+    bool started_ = false;
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef STATIC_GAME__
+#define STATIC_GAME__
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "map.h"
+#include "player.h"
+#include "policy.h"
+#include "rng.h"
+
+// ================== Static Board ==================
+// A board known at compile time, as written by `mapc --header`: a struct
+// of constexpr tables indexed by unit id.
+//
+//   struct Board {
+//       static constexpr int kUnitCount;
+//       static constexpr UnitKind kKind[kUnitCount];
+//       static constexpr int32_t kPrice[kUnitCount];
+//       static constexpr int32_t kUpgradePrice[kUnitCount];
+//       static constexpr int32_t kParam[kUnitCount];     // unitFine (C) / finePerPoint (R)
+//       static constexpr int32_t kFines[kUnitCount][5];  // U only, level 1..5
+//       static constexpr const char* kName[kUnitCount];
+//   };
+
+// The tables as map.dat lines, for the engines that build their board at
+// run time (WorldMap, BoardLayout). No file is read.
+template <class Board>
+std::vector<UnitSpec> staticBoardSpecs() {
+    std::vector<UnitSpec> specs(Board::kUnitCount);
+    for (int u = 0; u < Board::kUnitCount; ++u) {
+        UnitSpec& spec = specs[u];
+        spec.kind = Board::kKind[u];
+        spec.name = Board::kName[u];
+        spec.price = Board::kPrice[u];
+        spec.upgradePrice = Board::kUpgradePrice[u];
+        spec.param = Board::kParam[u];
+        for (int l = 0; l < 5; ++l) spec.fines[l] = Board::kFines[u][l];
+    }
+    return specs;
+}
+
+// ================== Static Game ==================
+// FastGame with the board baked in: every table is a constant at a fixed
+// address, the board size is a constant (the move is a lookup in a
+// constexpr step table instead of a division) and the per-player arrays
+// live inside the object, so the hot loop does no pointer chasing at all.
+// No file is read and nothing is built at startup.
+//
+// The visit is a switch on the unit kind. Generating one visit function
+// per unit and jumping through a table of them was tried and lost by about
+// a quarter: with random dice that indirect jump over every unit
+// mispredicts far more often than the four-way switch.
+//
+// Same rules, dice and policy calls as Game and FastGame: the same seed
+// gives the same game. Up to kMaxPlayers seats; there are no snapshots.
+template <class Board>
+class StaticGame {
+public:
+    static constexpr int kUnits = Board::kUnitCount;
+    static constexpr int kMaxPlayers = 64;
+    static constexpr int16_t kNoOwner = -1;
+
+    // numPlayers is clamped to 1..kMaxPlayers.
+    explicit StaticGame(int numPlayers, uint64_t seed = 0, uint64_t stream = 0)
+        : numPlayers_(numPlayers < 1 ? 1 : (numPlayers > kMaxPlayers ? kMaxPlayers : numPlayers)) {
+        policies_.fill(nullptr);
+        reset(seed, stream);
+    }
+
+    void reset(uint64_t seed, uint64_t stream = 0) {
+        units_.fill(UnitState{kNoOwner, 1});
+        location_.fill(0);
+        money_.fill(30000);
+        status_.fill(uint8_t(PlayerStatus::Normal));
+        collectables_.fill(0);
+        rng_.seed(seed, stream);
+        current_ = 0;
+        activePlayers_ = numPlayers_;
+        turns_ = 0;
+        over_ = false;
+    }
+
+    void setPolicy(int playerIndex, DecisionPolicy* policy) {
+        if (playerIndex >= 0 && playerIndex < numPlayers_) policies_[playerIndex] = policy;
+    }
+
+    void playTurn() {
+        const int p = current_;
+        if (status_[p] == uint8_t(PlayerStatus::Bankrupt)) {
+            advance();
+            return;
+        }
+        ++turns_;
+        if (status_[p] == uint8_t(PlayerStatus::InJail)) {
+            status_[p] = uint8_t(PlayerStatus::Normal);
+            advance();
+            return;
+        }
+
+        int oldLocation = location_[p];
+        int newLocation = kStep[oldLocation * 8 + rng_.rollDie()];
+        if (newLocation < oldLocation) {
+            money_[p] += 2000;
+        }
+        location_[p] = newLocation;
+
+        visit(p, newLocation);
+
+        if (money_[p] < 0) {
+            bankrupt(p);
+            --activePlayers_;
+        }
+        advance();
+        if (activePlayers_ <= 1) {
+            over_ = true;
+        }
+    }
+
+    // Plays until one player is left or maxTurns turns were started.
+    // Returns the id of the richest active player.
+    int runToCompletion(long maxTurns) {
+        while (!over_ && turns_ < maxTurns) {
+            playTurn();
+        }
+        return getLeader();
+    }
+
+    bool isOver() const { return over_; }
+    long getTurnCount() const { return turns_; }
+    int getCurrentPlayerIndex() const { return current_; }
+    int getPlayerCount() const { return numPlayers_; }
+    int getMoney(int player) const { return money_[player]; }
+    int getLocation(int player) const { return location_[player]; }
+    PlayerStatus getStatus(int player) const { return PlayerStatus(status_[player]); }
+    int getOwner(int unit) const { return units_[unit].owner; }
+    int getLevel(int unit) const { return units_[unit].level; }
+
+    int getLeader() const {
+        int leader = -1;
+        for (int i = 0; i < numPlayers_; ++i) {
+            if (status_[i] == uint8_t(PlayerStatus::Bankrupt)) continue;
+            if (leader < 0 || money_[i] > money_[leader]) leader = i;
+        }
+        return leader;
+    }
+
+private:
+    struct UnitState {
+        int16_t owner;
+        int8_t level;
+    };
+
+    // kStep[unit * 8 + die]: where a die of 1..6 from unit lands.
+    static constexpr std::array<int32_t, kUnits * 8> makeStepTable() {
+        std::array<int32_t, kUnits * 8> step{};
+        for (int u = 0; u < kUnits; ++u) {
+            for (int die = 0; die < 8; ++die) step[u * 8 + die] = (u + die) % kUnits;
+        }
+        return step;
+    }
+    static constexpr std::array<int32_t, kUnits * 8> kStep = makeStepTable();
+
+    void visit(int p, int u) {
+        UnitState& unit = units_[u];
+        const int host = unit.owner;
+        switch (Board::kKind[u]) {
+        case UnitKind::Upgradable:
+            if (host == kNoOwner) {
+                if (offer(DecisionKind::Buy, p, u, Board::kPrice[u], 1)) {
+                    unit.owner = int16_t(p);
+                }
+            }
+            else if (host != p) {
+                payRent(p, host, Board::kFines[u][unit.level - 1]);
+            }
+            else if (unit.level < 5) {
+                if (offer(DecisionKind::Upgrade, p, u, Board::kUpgradePrice[u], unit.level)) {
+                    ++unit.level;
+                }
+            }
+            break;
+        case UnitKind::Collectable:
+            if (host == kNoOwner) {
+                if (offer(DecisionKind::Buy, p, u, Board::kPrice[u], 1)) {
+                    unit.owner = int16_t(p);
+                    ++collectables_[p];
+                }
+            }
+            else if (host != p) {
+                payRent(p, host, collectables_[host] * Board::kParam[u]);
+            }
+            break;
+        case UnitKind::RandomCost:
+            if (host == kNoOwner) {
+                if (offer(DecisionKind::Buy, p, u, Board::kPrice[u], 1)) {
+                    unit.owner = int16_t(p);
+                }
+            }
+            else if (host != p) {
+                payRent(p, host, rng_.rollDie() * Board::kParam[u]);
+            }
+            break;
+        case UnitKind::Jail:
+            status_[p] = uint8_t(PlayerStatus::InJail);
+            break;
+        }
+    }
+
+    bool offer(DecisionKind kind, int p, int u, int price, int level) {
+        if (money_[p] < price) return false;
+        Decision decision;
+        decision.kind = kind;
+        decision.playerId = p;
+        decision.unitId = u;
+        decision.money = money_[p];
+        decision.price = price;
+        decision.level = level;
+        if (!policies_[p]->decide(decision)) return false;
+        money_[p] -= price;
+        return true;
+    }
+
+    // Same semantics as Player::pay and FastGame::payRent.
+    void payRent(int p, int host, int fine) {
+        int payment = money_[p] < fine ? money_[p] : fine;
+        money_[p] -= fine;
+        money_[host] += payment;
+    }
+
+    void bankrupt(int p) {
+        status_[p] = uint8_t(PlayerStatus::Bankrupt);
+        for (UnitState& unit : units_) {
+            if (unit.owner == p) {
+                unit.owner = kNoOwner;
+                unit.level = 1;
+            }
+        }
+        collectables_[p] = 0;
+    }
+
+    void advance() {
+        current_ = (current_ + 1) % numPlayers_;
+    }
+
+    int numPlayers_ = 0;
+    std::array<UnitState, kUnits> units_;
+    std::array<int32_t, kMaxPlayers> location_;
+    std::array<int32_t, kMaxPlayers> money_;
+    std::array<uint8_t, kMaxPlayers> status_;
+    std::array<int32_t, kMaxPlayers> collectables_;
+    std::array<DecisionPolicy*, kMaxPlayers> policies_;
+    Rng rng_;
+    int current_ = 0;
+    int activePlayers_ = 0;
+    long turns_ = 0;
+    bool over_ = false;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "stats.h"
+#include <bit>
+#include <ostream>
+
+
+namespace {
+const char* const kUpgradeFields[4] = {"upgrades_l2", "upgrades_l3", "upgrades_l4", "upgrades_l5"};
+
+uint64_t read(const std::atomic<uint64_t>& cell) {
+    return cell.load(std::memory_order_relaxed);
+}
+}
+
+// ================== Game Stats ==================
+GameStats::GameStats(int unitCount, int numPlayers)
+    : units_(new Unit[unitCount]), wins_(new std::atomic<uint64_t>[numPlayers]),
+      unitCount_(unitCount), numPlayers_(numPlayers) {
+    for (int i = 0; i < numPlayers; ++i) wins_[i].store(0, std::memory_order_relaxed);
+}
+
+void GameStats::bankrupt(long turn) {
+    int bucket = std::bit_width(uint64_t(turn));
+    bump(bankruptcies_[bucket < kTurnBuckets ? bucket : kTurnBuckets - 1], 1);
+}
+
+void GameStats::endGame(int winner, bool over, long turns) {
+    bump(games_, 1);
+    bump(turns_, uint64_t(turns));
+    if (!over) bump(capped_, 1);
+    if (winner >= 0 && winner < numPlayers_) bump(wins_[winner], 1);
+}
+
+void GameStats::addTo(StatsSummary& summary) const {
+    if (summary.units.empty()) {
+        summary.units.resize(unitCount_);
+        summary.bankruptcies.assign(kTurnBuckets, 0);
+        summary.wins.assign(numPlayers_, 0);
+    }
+    summary.games += read(games_);
+    summary.turns += read(turns_);
+    summary.capped += read(capped_);
+    for (int u = 0; u < unitCount_; ++u) {
+        const Unit& from = units_[u];
+        StatsSummary::Unit& to = summary.units[u];
+        to.landings += read(from.landings);
+        to.rent += read(from.rent);
+        to.buyOffers += read(from.buyOffers);
+        to.buys += read(from.buys);
+        to.upgradeOffers += read(from.upgradeOffers);
+        for (int l = 0; l < 4; ++l) to.upgrades[l] += read(from.upgrades[l]);
+    }
+    for (int b = 0; b < kTurnBuckets; ++b) summary.bankruptcies[b] += read(bankruptcies_[b]);
+    for (int i = 0; i < numPlayers_; ++i) summary.wins[i] += read(wins_[i]);
+}
+
+// ================== Stats Collector ==================
+GameStats& StatsCollector::addThread() {
+    std::lock_guard<std::mutex> lock(lock_);
+    threads_.push_back(std::make_unique<GameStats>(unitCount_, numPlayers_));
+    return *threads_.back();
+}
+
+StatsSummary StatsCollector::snapshot() const {
+    StatsSummary summary;
+    std::lock_guard<std::mutex> lock(lock_);
+    for (const auto& stats : threads_) stats->addTo(summary);
+    return summary;
+}
+
+// ================== Stats Summary ==================
+void StatsSummary::writeCsvHeader(std::ostream& out) {
+    out << "games,table,key,field,value\n";
+}
+
+void StatsSummary::writeCsv(std::ostream& out) const {
+    auto row = [&](const char* table, uint64_t key, const char* field, uint64_t value) {
+        out << games << ',' << table << ',' << key << ',' << field << ',' << value << '\n';
+    };
+    row("total", 0, "turns", turns);
+    row("total", 0, "capped", capped);
+    for (size_t u = 0; u < units.size(); ++u) {
+        const Unit& unit = units[u];
+        row("unit", u, "landings", unit.landings);
+        row("unit", u, "rent", unit.rent);
+        row("unit", u, "buy_offers", unit.buyOffers);
+        row("unit", u, "buys", unit.buys);
+        row("unit", u, "upgrade_offers", unit.upgradeOffers);
+        for (int l = 0; l < 4; ++l) row("unit", u, kUpgradeFields[l], unit.upgrades[l]);
+    }
+    // Keyed by the first turn of the bucket.
+    for (size_t b = 0; b < bankruptcies.size(); ++b) {
+        if (bankruptcies[b]) row("bankruptcy", b ? uint64_t(1) << (b - 1) : 0, "count", bankruptcies[b]);
+    }
+    for (size_t i = 0; i < wins.size(); ++i) row("seat", i, "wins", wins[i]);
+}
+
+void StatsSummary::writeJson(std::ostream& out) const {
+    out << "{\"games\": " << games << ", \"turns\": " << turns << ", \"capped\": " << capped
+        << ", \"units\": [";
+    for (size_t u = 0; u < units.size(); ++u) {
+        const Unit& unit = units[u];
+        out << (u ? ", " : "") << "{\"unit\": " << u << ", \"landings\": " << unit.landings
+            << ", \"rent\": " << unit.rent << ", \"buy_offers\": " << unit.buyOffers
+            << ", \"buys\": " << unit.buys << ", \"upgrade_offers\": " << unit.upgradeOffers
+            << ", \"upgrades\": [" << unit.upgrades[0] << ", " << unit.upgrades[1] << ", "
+            << unit.upgrades[2] << ", " << unit.upgrades[3] << "]}";
+    }
+    out << "], \"bankruptcy_turns\": [";
+    bool first = true;
+    for (size_t b = 0; b < bankruptcies.size(); ++b) {
+        if (!bankruptcies[b]) continue;
+        out << (first ? "" : ", ") << "{\"from\": " << (b ? uint64_t(1) << (b - 1) : 0)
+            << ", \"count\": " << bankruptcies[b] << "}";
+        first = false;
+    }
+    out << "], \"wins\": [";
+    for (size_t i = 0; i < wins.size(); ++i) out << (i ? ", " : "") << wins[i];
+    out << "]}\n";
+}
@@ -0,0 +1,119 @@
+#ifndef STATS__
+#define STATS__
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "policy.h"
+
+// ================== Stats Summary ==================
+// Plain totals over any number of games, as merged by StatsCollector.
+struct StatsSummary {
+    struct Unit {
+        uint64_t landings = 0;
+        uint64_t rent = 0;          // what hosts actually received here
+        uint64_t buyOffers = 0;
+        uint64_t buys = 0;
+        uint64_t upgradeOffers = 0;
+        uint64_t upgrades[4] = {};  // to level 2..5
+    };
+
+    uint64_t games = 0;
+    uint64_t turns = 0;
+    uint64_t capped = 0;            // games stopped by the turn cap or a stall
+    std::vector<Unit> units;
+    std::vector<uint64_t> bankruptcies;   // GameStats::kTurnBuckets buckets
+    std::vector<uint64_t> wins;           // per seat
+
+    // One line per snapshot, so a file of snapshots streams: CSV rows
+    // "games,table,key,field,value" (writeCsvHeader() once first), or one
+    // JSON object per line.
+    static void writeCsvHeader(std::ostream& out);
+    void writeCsv(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+};
+
+// ================== Game Stats ==================
+// What happens in the games one thread plays: landings, rent, buy and
+// upgrade offers per unit, the turn of every bankruptcy (log2 buckets) and
+// who won.
+//
+// Only the owning thread writes, with a relaxed load and store per event
+// (plain moves on x86); StatsCollector reads concurrently. No locks and no
+// read-modify-write, so the engine barely notices.
+class alignas(64) GameStats {
+public:
+    static constexpr int kTurnBuckets = 32;   // bucket b holds turns in [2^(b-1), 2^b)
+
+    GameStats(int unitCount, int numPlayers);
+    GameStats(const GameStats&) = delete;
+    GameStats& operator=(const GameStats&) = delete;
+
+    void land(int unit) { bump(units_[unit].landings, 1); }
+    void rent(int unit, int amount) { bump(units_[unit].rent, uint64_t(amount)); }
+    // `level` is the unit's level before an upgrade.
+    void offer(DecisionKind kind, int unit, int level, bool accepted) {
+        Unit& u = units_[unit];
+        if (kind == DecisionKind::Buy) {
+            bump(u.buyOffers, 1);
+            if (accepted) bump(u.buys, 1);
+        } else {
+            bump(u.upgradeOffers, 1);
+            if (accepted) bump(u.upgrades[level - 1], 1);
+        }
+    }
+    void bankrupt(long turn);
+    void endGame(int winner, bool over, long turns);
+
+    // Adds these totals to summary (sized on first use).
+    void addTo(StatsSummary& summary) const;
+
+private:
+    struct Unit {
+        std::atomic<uint64_t> landings{0};
+        std::atomic<uint64_t> rent{0};
+        std::atomic<uint64_t> buyOffers{0};
+        std::atomic<uint64_t> buys{0};
+        std::atomic<uint64_t> upgradeOffers{0};
+        std::atomic<uint64_t> upgrades[4] = {};
+    };
+
+    static void bump(std::atomic<uint64_t>& cell, uint64_t value) {
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Unit[]> units_;
+    std::unique_ptr<std::atomic<uint64_t>[]> wins_;
+    std::atomic<uint64_t> bankruptcies_[kTurnBuckets] = {};
+    std::atomic<uint64_t> games_{0};
+    std::atomic<uint64_t> turns_{0};
+    std::atomic<uint64_t> capped_{0};
+    int unitCount_ = 0;
+    int numPlayers_ = 0;
+};
+
+// ================== Stats Collector ==================
+// Hands out one GameStats per thread and sums them on demand. addThread()
+// and snapshot() take the lock (a snapshot holds up a thread registering,
+// nothing else); the workers' own writes to their GameStats never do, so
+// snapshot() can run while every thread keeps playing, and shows each
+// field as of some moment during the call.
+class StatsCollector {
+public:
+    StatsCollector(int unitCount, int numPlayers) : unitCount_(unitCount), numPlayers_(numPlayers) {}
+
+    GameStats& addThread();
+    StatsSummary snapshot() const;
+
+private:
+    int unitCount_;
+    int numPlayers_;
+    mutable std::mutex lock_;
+    std::vector<std::unique_ptr<GameStats>> threads_;
+};
+
+#endif
@@ -0,0 +1,380 @@
+// Plays many headless games of one board across all cores and reports
+// win rates and game lengths.
+//
+//   tournament [-g games] [-p players] [-t threads] [-s seed]
+//              [-m map.dat] [--max-turns N] [--reserve R] [--fast | --batch]
+//              [--stats file [--stats-every S]] [--stall-repeats N]
+//
+// -m takes either a map.dat or an image compiled by mapc. The board is
+// loaded once and every worker's games share its unit definitions.
+// --fast plays on the struct-of-arrays FastGame engine instead of the
+// MapUnit-based Game; both produce the same results for the same seed.
+// --batch plays BatchGame::kLanes games at a time in SIMD lanes, again with
+// the same results.
+//
+// --stats (with --fast) writes per-unit landings, rent, buy and upgrade
+// rates, the turns players went bankrupt and the winners: each worker
+// counts into its own GameStats and the totals are merged at the end, and
+// every S seconds meanwhile with --stats-every. A file named *.json gets
+// one JSON object per snapshot, anything else CSV rows.
+//
+// --stall-repeats N (with --fast) ends a game early once the same state,
+// positions aside, has started N rounds (see FastGame::setStallLimit):
+// bots that never buy again would otherwise run to the turn cap. Money
+// saturates in that state (see zobrist.h), so it also ends rich games
+// that only move cash around.
+//
+// --mcts-seat S puts an MCTS bot in seat S (budget --mcts-ms per decision,
+// --mcts-threads search threads per worker) and reports its rollouts/sec.
+// --mcts-transpositions keys its tree by state (MctsPolicy::Options).
+//
+// Built with -DMONOPOLY_EMBEDDED_BOARD (see mapc --header), the board in
+// embedded_board.h is the default and no file is read unless -m is given;
+// --static then plays on StaticGame, the engine specialized for that board.
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch_game.h"
+#include "fast_game.h"
+#include "game.h"
+#include "map.h"
+#include "map_image.h"
+#include "mcts.h"
+#include "player.h"
+#include "policy.h"
+#include "scheduler.h"
+#include "stats.h"
+#ifdef MONOPOLY_EMBEDDED_BOARD
+#include "embedded_board.h"
+#include "static_game.h"
+#endif
+
+enum class Engine { Game, Fast, Static, Batch };
+
+// Everything one worker thread owns: its board, seats, engine and tallies.
+// Nothing here is shared, so workers never contend while playing.
+struct alignas(64) Worker {
+    Worker(int numPlayers, const std::vector<UnitSpec>& specs, const BoardLayout& layout,
+           std::vector<std::string>& names, int reserve)
+        : map(numPlayers, specs), players(numPlayers, names), game(map, players),
+          fastGame(layout, numPlayers), batchGame(layout, numPlayers, reserve),
+#ifdef MONOPOLY_EMBEDDED_BOARD
+          staticGame(numPlayers),
+#endif
+          policy(reserve), wins(numPlayers, 0) {
+        for (int i = 0; i < numPlayers; ++i) {
+            game.setPolicy(i, &policy);
+            fastGame.setPolicy(i, &policy);
+#ifdef MONOPOLY_EMBEDDED_BOARD
+            staticGame.setPolicy(i, &policy);
+#endif
+        }
+    }
+
+    // Seats an MCTS bot that searches from whichever engine is playing.
+    void addMcts(int seat, const BoardLayout& layout, const MctsPolicy::Options& options, Engine engine) {
+        bool fast = engine == Engine::Fast;
+        mcts = std::make_unique<MctsPolicy>(layout, players.getPlayerCount(), options,
+            [this, fast](GameState& state) { return fast ? fastGame.save(state) : game.save(state); });
+        game.setPolicy(seat, mcts.get());
+        fastGame.setPolicy(seat, mcts.get());
+    }
+
+    // Plays game `index` on the chosen engine and records the outcome.
+    void play(Engine engine, uint64_t seed, long index, long maxTurns) {
+        int winner;
+        bool over;
+        long gameTurns;
+        if (engine == Engine::Fast) {
+            fastGame.reset(seed, index); // game i always gets stream i
+            winner = fastGame.runToCompletion(maxTurns);
+            over = fastGame.isOver();
+            gameTurns = fastGame.getTurnCount();
+            if (fastGame.isStalled()) stalled++;
+        }
+#ifdef MONOPOLY_EMBEDDED_BOARD
+        else if (engine == Engine::Static) {
+            staticGame.reset(seed, index);
+            winner = staticGame.runToCompletion(maxTurns);
+            over = staticGame.isOver();
+            gameTurns = staticGame.getTurnCount();
+        }
+#endif
+        else {
+            game.reset(seed, index);
+            winner = game.runToCompletion(maxTurns);
+            over = game.isOver();
+            gameTurns = game.getTurnCount();
+        }
+        record(winner, over, gameTurns);
+    }
+
+    // Plays games first .. first + count - 1 side by side on BatchGame.
+    void playBatch(uint64_t seed, long first, int count, long maxTurns) {
+        batchGame.play(seed, first, count, maxTurns);
+        for (int lane = 0; lane < count; ++lane) {
+            record(batchGame.getWinner(lane), batchGame.isOver(lane), batchGame.getTurnCount(lane));
+        }
+    }
+
+    void record(int winner, bool over, long gameTurns) {
+        if (stats) stats->endGame(winner, over, gameTurns);
+        if (!over) capped++;
+        if (winner >= 0) wins[winner]++;
+        games++;
+        turns += gameTurns;
+    }
+
+    WorldMap map;
+    WorldPlayer players;
+    Game game;
+    FastGame fastGame;
+    BatchGame batchGame;
+#ifdef MONOPOLY_EMBEDDED_BOARD
+    StaticGame<EmbeddedBoard> staticGame;
+#endif
+    ThresholdPolicy policy;
+    std::unique_ptr<MctsPolicy> mcts;
+    GameStats* stats = nullptr;
+    std::vector<long> wins;
+    long games = 0;
+    long turns = 0;
+    long capped = 0;
+    long stalled = 0;
+};
+
+int main(int argc, char** argv) {
+    long numGames = 10000;
+    int numPlayers = 4;
+    int numThreads = std::thread::hardware_concurrency();
+    uint64_t seed = 1;
+#ifdef MONOPOLY_EMBEDDED_BOARD
+    std::string mapPath;
+#else
+    std::string mapPath = "map.dat";
+#endif
+    long maxTurns = 10000;
+    int reserve = 0;
+    Engine engine = Engine::Game;
+    int mctsSeat = -1;
+    MctsPolicy::Options mctsOptions;
+    std::string statsPath;
+    double statsEvery = 0;
+    int stallRepeats = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-g" && hasValue) numGames = std::atol(argv[++i]);
+        else if (arg == "-p" && hasValue) numPlayers = std::atoi(argv[++i]);
+        else if (arg == "-t" && hasValue) numThreads = std::atoi(argv[++i]);
+        else if (arg == "-s" && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "-m" && hasValue) mapPath = argv[++i];
+        else if (arg == "--max-turns" && hasValue) maxTurns = std::atol(argv[++i]);
+        else if (arg == "--reserve" && hasValue) reserve = std::atoi(argv[++i]);
+        else if (arg == "--fast") engine = Engine::Fast;
+        else if (arg == "--batch") engine = Engine::Batch;
+#ifdef MONOPOLY_EMBEDDED_BOARD
+        else if (arg == "--static") engine = Engine::Static;
+#endif
+        else if (arg == "--mcts-seat" && hasValue) mctsSeat = std::atoi(argv[++i]);
+        else if (arg == "--mcts-ms" && hasValue) mctsOptions.budget = std::chrono::microseconds(long(std::atof(argv[++i]) * 1000));
+        else if (arg == "--mcts-threads" && hasValue) mctsOptions.threads = std::atoi(argv[++i]);
+        else if (arg == "--mcts-transpositions") mctsOptions.transpositions = true;
+        else if (arg == "--stats" && hasValue) statsPath = argv[++i];
+        else if (arg == "--stats-every" && hasValue) statsEvery = std::atof(argv[++i]);
+        else if (arg == "--stall-repeats" && hasValue) stallRepeats = std::atoi(argv[++i]);
+        else {
+            std::cerr << "usage: tournament [-g games] [-p players] [-t threads] [-s seed]"
+                         " [-m map.dat] [--max-turns N] [--reserve R] [--fast | --batch]"
+                         " [--mcts-seat S] [--mcts-ms M] [--mcts-threads T] [--mcts-transpositions]"
+                         " [--stats file [--stats-every S]] [--stall-repeats N]\n";
+            return 1;
+        }
+    }
+    if (numPlayers < 1) numPlayers = 1;
+    if (numThreads < 1) numThreads = 1;
+    if (engine == Engine::Static && (!mapPath.empty() || mctsSeat >= 0)) {
+        std::cerr << "--static plays the embedded board only, without MCTS seats\n";
+        return 1;
+    }
+    if (engine == Engine::Batch && mctsSeat >= 0) {
+        std::cerr << "--batch plays threshold bots only, without MCTS seats\n";
+        return 1;
+    }
+    if (!statsPath.empty() && engine != Engine::Fast) {
+        std::cerr << "--stats is collected by the --fast engine\n";
+        return 1;
+    }
+    if (stallRepeats > 0 && engine != Engine::Fast) {
+        std::cerr << "--stall-repeats needs the --fast engine\n";
+        return 1;
+    }
+#ifdef MONOPOLY_EMBEDDED_BOARD
+    if (engine == Engine::Static && numPlayers > StaticGame<EmbeddedBoard>::kMaxPlayers) {
+        std::cerr << "--static seats at most " << StaticGame<EmbeddedBoard>::kMaxPlayers << " players\n";
+        return 1;
+    }
+#endif
+
+    std::vector<std::string> names;
+    for (int i = 0; i < numPlayers; ++i) {
+        names.push_back("Bot-" + std::to_string(i));
+    }
+
+    // Prefer a compiled image; fall back to parsing map.dat text.
+    MapImage image;
+    std::string imageError;
+    std::vector<UnitSpec> specs;
+    std::unique_ptr<BoardLayout> layout;
+#ifdef MONOPOLY_EMBEDDED_BOARD
+    if (mapPath.empty()) {
+        specs = staticBoardSpecs<EmbeddedBoard>();
+        layout = std::make_unique<BoardLayout>(specs);
+        mapPath = "embedded board";
+    } else
+#endif
+    if (image.open(mapPath, imageError)) {
+        specs = image.toSpecs();
+        layout = std::make_unique<BoardLayout>(image);
+    } else {
+        std::vector<std::string> errors;
+        parseMapFile(mapPath, specs, errors);
+        for (const auto& error : errors) std::cerr << error << "\n";
+        layout = std::make_unique<BoardLayout>(specs);
+    }
+    if (specs.empty()) {
+        std::cerr << mapPath << ": no units\n";
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int w = 0; w < numThreads; ++w) {
+        workers.push_back(std::make_unique<Worker>(numPlayers, specs, *layout, names, reserve));
+        workers.back()->fastGame.setStallLimit(stallRepeats);
+        if (mctsSeat >= 0 && mctsSeat < numPlayers) {
+            mctsOptions.opponentReserve = reserve;
+            mctsOptions.seed = seed + w;
+            workers.back()->addMcts(mctsSeat, *layout, mctsOptions, engine);
+        }
+    }
+
+    std::unique_ptr<StatsCollector> collector;
+    std::ofstream statsFile;
+    const bool statsJson = statsPath.size() >= 5 && statsPath.compare(statsPath.size() - 5, 5, ".json") == 0;
+    if (!statsPath.empty()) {
+        statsFile.open(statsPath, std::ios::trunc);
+        if (!statsFile) {
+            std::cerr << statsPath << ": cannot write\n";
+            return 1;
+        }
+        if (!statsJson) StatsSummary::writeCsvHeader(statsFile);
+        collector = std::make_unique<StatsCollector>(layout->unitCount, numPlayers);
+        for (auto& worker : workers) {
+            worker->stats = &collector->addThread();
+            worker->fastGame.setStats(worker->stats);
+        }
+    }
+    auto writeStats = [&] {
+        StatsSummary summary = collector->snapshot();
+        if (statsJson) summary.writeJson(statsFile);
+        else summary.writeCsv(statsFile);
+        statsFile.flush();
+    };
+
+    // Interim snapshots read the workers' counters while they play.
+    std::mutex reportLock;
+    std::condition_variable reportWake;
+    bool finished = false;
+    std::thread reporter;
+    if (collector && statsEvery > 0) {
+        reporter = std::thread([&] {
+            std::unique_lock<std::mutex> lock(reportLock);
+            auto period = std::chrono::duration<double>(statsEvery);
+            while (!reportWake.wait_for(lock, period, [&] { return finished; })) {
+                writeStats();
+            }
+        });
+    }
+
+    WorkStealingScheduler scheduler(numThreads);
+    auto start = std::chrono::steady_clock::now();
+
+    if (engine == Engine::Batch) {
+        const int lanes = BatchGame::kLanes;
+        scheduler.run((numGames + lanes - 1) / lanes, [&](int w, long block) {
+            long first = block * lanes;
+            workers[w]->playBatch(seed, first, int(std::min<long>(lanes, numGames - first)), maxTurns);
+        });
+    } else {
+        scheduler.run(numGames, [&](int w, long index) {
+            workers[w]->play(engine, seed, index, maxTurns);
+        });
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (reporter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(reportLock);
+            finished = true;
+        }
+        reportWake.notify_one();
+        reporter.join();
+    }
+    if (collector) writeStats();
+
+    // Merge the per-worker tallies once everyone has finished.
+    std::vector<long> wins(numPlayers, 0);
+    long games = 0, turns = 0, capped = 0, stalled = 0;
+    for (const auto& worker : workers) {
+        for (int i = 0; i < numPlayers; ++i) wins[i] += worker->wins[i];
+        games += worker->games;
+        turns += worker->turns;
+        capped += worker->capped - worker->stalled;
+        stalled += worker->stalled;
+    }
+
+    std::cout << "games " << games << " on " << numThreads << " threads in "
+              << std::fixed << std::setprecision(3) << seconds << " s\n";
+    std::cout << "games/sec " << std::setprecision(0) << games / seconds
+              << "  turns/sec " << turns / seconds << "\n";
+    std::cout << "avg turns " << std::setprecision(1) << double(turns) / (games ? games : 1)
+              << "  hit turn cap " << capped;
+    if (stallRepeats > 0) std::cout << "  stalled " << stalled;
+    std::cout << "\n";
+    if (mctsSeat >= 0 && mctsSeat < numPlayers) {
+        long rollouts = 0, decisions = 0, fallbacks = 0;
+        double searchSeconds = 0;
+        for (const auto& worker : workers) {
+            rollouts += worker->mcts->getTotalRollouts();
+            searchSeconds += worker->mcts->getTotalSearchSeconds();
+            decisions += worker->mcts->getDecisions();
+            fallbacks += worker->mcts->getFallbacks();
+        }
+        std::cout << "mcts seat " << mctsSeat << "  rollouts " << rollouts << "  rollouts/sec "
+                  << std::setprecision(0) << (searchSeconds > 0 ? rollouts / searchSeconds : 0)
+                  << "  decisions " << decisions << "  not searched " << fallbacks << "\n";
+        // The seat's win rate is only MCTS's to the extent it searched.
+        if (fallbacks > 0) {
+            std::cerr << "mcts seat " << mctsSeat << ": " << fallbacks << " of " << decisions
+                      << " decisions could not be snapshotted and used the threshold rule\n";
+        }
+    }
+    for (int i = 0; i < numPlayers; ++i) {
+        std::cout << "seat " << i << "  wins " << std::setw(8) << wins[i]
+                  << "  rate " << std::setprecision(2) << 100.0 * wins[i] / (games ? games : 1) << "%\n";
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef ZOBRIST__
+#define ZOBRIST__
+
+#include <cstdint>
+
+#include "game_state.h"
+
+// ================== Zobrist Hashing ==================
+// A game state hashes to the XOR of one key per feature it has: each
+// owned unit's owner, each upgradable unit's level above 1, and per player
+// the location, money bucket and status, plus the seat to move. Unowned
+// units, level 1 and the normal status have no key, so an untouched board
+// hashes to 0 and a purchase or upgrade changes the hash by one or two
+// XORs.
+//
+// Keys are computed rather than looked up: key(feature, a, b) is a
+// splitmix64 finalizer over its arguments, the same for every board size
+// and every engine, so hashes from Game and FastGame snapshots agree.
+//
+// Money counts in buckets of kMoneyBucket (saturating at the last of
+// kMoneyBuckets): two states that only differ by small change are the
+// same state.
+namespace zobrist {
+
+enum Feature : uint64_t { Location = 1, Money, Status, Owner, Level, ToMove, Decision };
+
+const int kMoneyBucket = 1000;
+const int kMoneyBuckets = 256;
+
+inline uint64_t key(Feature feature, uint64_t a, uint64_t b = 0) {
+    uint64_t z = (uint64_t(feature) << 56) ^ (a << 24) ^ b;
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline int moneyBucket(int money) {
+    if (money <= 0) return 0;
+    int bucket = money / kMoneyBucket;
+    return bucket < kMoneyBuckets ? bucket : kMoneyBuckets - 1;
+}
+
+inline uint64_t ownerKey(int unit, int owner) { return owner < 0 ? 0 : key(Owner, unit, owner); }
+inline uint64_t levelKey(int unit, int level) { return level <= 1 ? 0 : key(Level, unit, level); }
+
+// Everything a player contributes. Locations can be left out: they keep
+// changing in a game where nothing else does.
+inline uint64_t playerKey(int player, int location, int money, int status, bool withLocation) {
+    uint64_t h = key(Money, player, moneyBucket(money));
+    if (status != 0) h ^= key(Status, player, status);
+    if (withLocation) h ^= key(Location, player, location);
+    return h;
+}
+
+// The hash of a snapshot from scratch; what the engines keep up to date.
+inline uint64_t hashState(const GameState& state, bool withLocations = true) {
+    uint64_t h = key(ToMove, state.currentPlayer);
+    for (int u = 0; u < int(state.unitCount); ++u) {
+        h ^= ownerKey(u, state.units[u].owner) ^ levelKey(u, state.units[u].level);
+    }
+    for (int p = 0; p < int(state.playerCount); ++p) {
+        const PlayerSnapshot& player = state.players[p];
+        h ^= playerKey(p, player.location, player.money, player.status, withLocations);
+    }
+    return h;
+}
+
+} // namespace zobrist
+
+#endif